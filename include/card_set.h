@@ -0,0 +1,118 @@
+#ifndef CARD_SET_H
+#define CARD_SET_H
+
+#include <stdint.h>
+
+#include "poker_client.h"  // for card_t
+
+/**
+ * a set of cards packed into a single 64 bit mask
+ *
+ * every suite gets its own 16 bit lane and a card sits at bit (suite * 16 + rank), so
+ *  - shifting a lane down gives a 13 bit rank mask for that suite
+ *  - or-ing the four lanes together gives the ranks present in the set
+ *  - union, intersection and removal of dead cards are plain |, & and &~
+ */
+
+typedef uint64_t card_set_t;
+
+#define CARD_SET_EMPTY      ((card_set_t) 0)
+#define CARD_SET_LANE_BITS  16
+#define CARD_SET_RANK_MASK  0x1fff
+#define CARD_SET_DECK       ((card_set_t) 0x1fff1fff1fff1fffULL)
+
+static inline card_set_t card_set_of(card_t card)
+{
+    return (card_set_t) 1 << (SUITE(card) * CARD_SET_LANE_BITS + RANK(card));
+}
+
+static inline card_set_t card_set_add(card_set_t set, card_t card)
+{
+    return set | card_set_of(card);
+}
+
+static inline card_set_t card_set_union(card_set_t a, card_set_t b)
+{
+    return a | b;
+}
+
+static inline card_set_t card_set_intersect(card_set_t a, card_set_t b)
+{
+    return a & b;
+}
+
+static inline card_set_t card_set_minus(card_set_t a, card_set_t b)
+{
+    return a & ~b;
+}
+
+static inline int card_set_contains(card_set_t set, card_t card)
+{
+    return (set & card_set_of(card)) != 0;
+}
+
+static inline int card_set_count(card_set_t set)
+{
+    return __builtin_popcountll(set);
+}
+
+/**
+ * @brief the ranks of one suite in the set
+ *
+ * @return a 13 bit mask, bit r is set if the card of rank r in that suite is in the set
+ */
+static inline int card_set_suite(card_set_t set, int suite)
+{
+    return (int) (set >> (suite * CARD_SET_LANE_BITS)) & CARD_SET_RANK_MASK;
+}
+
+/**
+ * @brief the ranks present in the set, regardless of suite
+ *
+ * @return a 13 bit mask, bit r is set if at least one card of rank r is in the set
+ */
+static inline int card_set_ranks(card_set_t set)
+{
+    return (int) (set | (set >> 16) | (set >> 32) | (set >> 48)) & CARD_SET_RANK_MASK;
+}
+
+/**
+ * @brief the lowest card of a non empty set (the order is by suite, then by rank)
+ */
+static inline card_t card_set_first(card_set_t set)
+{
+    int bit = __builtin_ctzll(set);
+    return ((bit % CARD_SET_LANE_BITS) << SUITE_BITS) | (bit / CARD_SET_LANE_BITS);
+}
+
+/**
+ * @brief builds a set out of an array of cards, NOCARD entries are skipped
+ */
+static inline card_set_t card_set_from_cards(const card_t *cards, int num_cards)
+{
+    card_set_t set = CARD_SET_EMPTY;
+    for (int i = 0; i < num_cards; i++)
+    {
+        if (cards[i] != NOCARD)
+            set = card_set_add(set, cards[i]);
+    }
+    return set;
+}
+
+/**
+ * @brief writes the cards of the set into out
+ *
+ * @return the number of cards written
+ */
+static inline int card_set_to_cards(card_set_t set, card_t *out)
+{
+    int n = 0;
+    while (set)
+    {
+        out[n++] = card_set_first(set);
+        set &= set - 1;
+    }
+    return n;
+}
+
+#endif
@@ -0,0 +1,102 @@
+#ifndef COMPACT_TABLE_H
+#define COMPACT_TABLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "game_logic.h"
+#include "platform.h"      // for CACHE_LINE
+
+/**
+ * a game_state_t packed for hosting many tables at once
+ *
+ * game_state_t spends 4 bytes on every card and status and mixes the sockets, the deck
+ * and the generator in with the betting fields, close to 700 bytes a table. here a table
+ * is split in two:
+ *  - compact_table_t, two cache lines: the first holds everything a betting action reads
+ *    or writes, the second the cards and hand values. cards and statuses are bytes.
+ *  - compact_table_cold_t: the deck, the generator and the sockets, only touched between
+ *    hands and when a card is drawn.
+ * the incremental hands (hands_so_far) and the seat masks are not stored at all, they are
+ * rebuilt from the cards and statuses on unpacking.
+ *
+ * the engine and the server work on game_state_t: a host keeps its idle tables packed
+ * and unpacks one to play on it, the accessors below read a packed table in place.
+ */
+
+#define COMPACT_NOCARD 0xff
+
+typedef struct {
+    // hot, the first cache line: the betting
+    int32_t player_stacks[MAX_PLAYERS];
+    int32_t current_bets[MAX_PLAYERS];
+    int32_t highest_bet;
+    int32_t pot_size;
+    uint8_t player_status[MAX_PLAYERS];            // player_status_t
+    uint8_t current_player;
+    uint8_t round_stage;                           // round_stage_t
+
+    // warm, the second cache line: the cards of the hand
+    int32_t hand_values[MAX_PLAYERS];
+    uint8_t player_hands[MAX_PLAYERS][HAND_SIZE];  // COMPACT_NOCARD for no card
+    uint8_t community_cards[MAX_COMMUNITY_CARDS];
+    uint8_t dealer_player;
+    uint8_t num_players;
+    uint8_t next_card;
+    uint8_t community_dealt;
+    uint16_t street_actions;
+} __attribute__((aligned(CACHE_LINE))) compact_table_t;
+
+_Static_assert(offsetof(compact_table_t, hand_values) == CACHE_LINE,
+               "the betting fields of compact_table_t must fill exactly one cache line");
+
+typedef struct {
+    uint8_t deck[DECK_SIZE];
+    deck_rng_t rng;
+    deck_queue_t *deck_queue;
+    int32_t sockets[MAX_PLAYERS];
+} compact_table_cold_t;
+
+/**
+ * @brief packs a table, game is left as it is
+ */
+void compact_table_pack(const game_state_t *game, compact_table_t *table, compact_table_cold_t *cold);
+
+/**
+ * @brief unpacks a table into game, rebuilding the incremental hands and the seat masks
+ *
+ * @note hand_eval_init() must have been called first
+ */
+void compact_table_unpack(const compact_table_t *table, const compact_table_cold_t *cold, game_state_t *game);
+
+static inline card_t compact_card(uint8_t card)
+{
+    return card == COMPACT_NOCARD ? NOCARD : (card_t) card;
+}
+
+static inline card_t compact_hole_card(const compact_table_t *table, player_id_t seat, int i)
+{
+    return compact_card(table->player_hands[seat][i]);
+}
+
+static inline card_t compact_board_card(const compact_table_t *table, int i)
+{
+    return compact_card(table->community_cards[i]);
+}
+
+static inline player_status_t compact_status(const compact_table_t *table, player_id_t seat)
+{
+    return (player_status_t) table->player_status[seat];
+}
+
+static inline round_stage_t compact_stage(const compact_table_t *table)
+{
+    return (round_stage_t) table->round_stage;
+}
+
+static inline int compact_to_call(const compact_table_t *table, player_id_t seat)
+{
+    return table->highest_bet - table->current_bets[seat];
+}
+
+#endif
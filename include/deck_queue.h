@@ -0,0 +1,64 @@
+#ifndef DECK_QUEUE_H
+#define DECK_QUEUE_H
+
+#include "game_logic.h"
+
+/**
+ * shuffles the decks of tables ahead of time on background threads
+ *
+ * a producer thread takes over the generator of every table attached to it and pushes
+ * every deck it shuffles, with the generator state right after it, into a bounded single
+ * producer single consumer ring per table. reset_game_state then only copies the next
+ * deck (and the state) out of the ring, so the table deals exactly the decks it would
+ * have shuffled itself and the hand can start without waiting on any RNG work.
+ *
+ * popping a deck is lock-free, the two sides only share a head and a tail index. the
+ * producer fills every ring up and then sleeps on a condition variable, a table wakes it
+ * when its ring drains to the low water mark (half the depth). a table that finds its
+ * ring empty sleeps too until the producer has pushed its next deck.
+ *
+ * one producer can serve several tables (a worker's tables, or a whole server), or each
+ * table gets a producer of its own. a lazy table has no decks to shuffle ahead, it cannot
+ * take a queue.
+ */
+
+#define DECK_QUEUE_DEFAULT_DEPTH 64
+#define DECK_PRODUCER_MAX_TABLES 64                 // tables one producer serves at most
+
+typedef struct deck_producer deck_producer_t;
+
+/**
+ * @brief starts a producer thread with no tables yet
+ *
+ * @return the producer, NULL if it could not be started
+ */
+deck_producer_t *deck_producer_start();
+
+/**
+ * @brief stops the producer thread, every table must be detached first
+ */
+void deck_producer_stop(deck_producer_t *producer);
+
+/**
+ * @brief gives a table a queue, decks come from the table's generator and deck
+ *
+ * @param producer the producer to shuffle on, NULL to start one for this table only
+ * @param depth the number of decks shuffled ahead, at least 1
+ * @return 0 on success, -1 for a lazy table, a table that already has a queue, a full
+ * producer or if the producer could not be started
+ */
+int deck_queue_attach(game_state_t *game, deck_producer_t *producer, int depth);
+
+/**
+ * @brief takes the table off its producer (stopping it if it was the table's own), the
+ * table shuffles inline again from where its queue was
+ */
+void deck_queue_detach(game_state_t *game);
+
+/**
+ * @brief copies the next deck into deck and the generator state after it into rng,
+ * waits for the producer if it is behind
+ */
+void deck_queue_pop(deck_queue_t *queue, card_t deck[DECK_SIZE], deck_rng_t *rng);
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include "game_logic.h"
+
+/**
+ * the rules of a hand, without any sockets
+ *
+ * the engine only changes a game_state_t and reports what happened as a list of events:
+ * cards dealt, streets starting, whose turn it is, actions taken or refused, seats
+ * leaving and the showdown. whoever drives it (the server, a simulation, a test) does
+ * the I/O for those events, e.g. the server sends INFO on a turn and ACK on an accepted
+ * action. nothing here blocks or prints, so hands run at memory speed.
+ *
+ * a hand starts with engine_start_hand() once the seats are ready, then every action of
+ * the seat to act goes through engine_apply() until the showdown event. the stage ends
+ * up at ROUND_SHOWDOWN, reset_game_state() readies the table for the next hand.
+ */
+
+#define ENGINE_MAX_EVENTS 16                       // an all in runout: 3 streets, a payout per seat and the showdown
+
+typedef enum {
+    ENGINE_EVENT_DEAL,                             // hole cards dealt to every active seat
+    ENGINE_EVENT_STREET,                           // a street is dealt and its betting starts (none on a runout), stage holds which one
+    ENGINE_EVENT_TURN,                             // seat is to act
+    ENGINE_EVENT_ACCEPTED,                         // the action of seat was applied
+    ENGINE_EVENT_REJECTED,                         // the action of seat was refused, nothing changed
+    ENGINE_EVENT_LEFT,                             // seat left the table
+    ENGINE_EVENT_PAYOUT,                           // seat collected amount from the pots, one per seat that won chips
+    ENGINE_EVENT_SHOWDOWN                          // the hand is over, seat won the main pot (the best hand if there was none), amount is the whole pot
+} engine_event_type_t;
+
+typedef struct {
+    engine_event_type_t type;
+    player_id_t seat;
+    round_stage_t stage;                           // the stage after the event
+    int amount;
+} engine_event_t;
+
+typedef struct {
+    int count;
+    engine_event_t events[ENGINE_MAX_EVENTS];
+} engine_events_t;
+
+/**
+ * @brief an action of the seat to act, the packet types a client bets with
+ */
+typedef struct {
+    client_packet_type_t type;                     // RAISE, CALL, CHECK or FOLD
+    int amount;                                    // what a RAISE adds to the highest bet, not negative
+} engine_action_t;
+
+/**
+ * @brief deals a new hand, the seats that are PLAYER_ACTIVE play it
+ *
+ * @param events cleared, then filled with the deal, the preflop street and the first turn
+ * @return 0 on success, -1 if the game is not at ROUND_INIT or fewer than 2 seats are active
+ */
+int engine_start_hand(game_state_t *game, engine_events_t *events);
+
+/**
+ * @brief applies an action of seat and moves the hand on
+ *
+ * an accepted action is followed by the next turn, or by the next street when every
+ * active seat has acted and matched the highest bet, or by the showdown after the river
+ * or once a single seat is left in the hand. when fewer than two seats are left to bet
+ * (the others all in) the rest of the board is dealt out street by street, straight to
+ * the showdown. a refused action is followed by a new turn for the same seat.
+ *
+ * @param events cleared, then filled with what happened
+ * @return 0 if the action was applied, -1 if it was refused (out of turn, outside of a
+ * betting round, a raise beyond the stack, a check facing a bet or not a betting action)
+ */
+int engine_apply(game_state_t *game, player_id_t seat, const engine_action_t *action, engine_events_t *events);
+
+/**
+ * @brief takes seat out of the game (a disconnect), a hand in progress carries on
+ * without it as if it had folded
+ */
+void engine_leave(game_state_t *game, player_id_t seat, engine_events_t *events);
+
+/**
+ * @brief checks an action against the betting rules and updates the bets, nothing else
+ *
+ * a call the stack cannot cover puts in the whole stack, and any bet that empties the
+ * stack leaves the seat PLAYER_ALLIN.
+ *
+ * @return 0 if applied, -1 if refused (nothing changes then)
+ */
+int engine_bet(game_state_t *game, player_id_t seat, const engine_action_t *action);
+
+#endif
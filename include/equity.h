@@ -0,0 +1,101 @@
+#ifndef EQUITY_H
+#define EQUITY_H
+
+#include <stdint.h>
+
+#include "game_logic.h"    // for HAND_SIZE, MAX_COMMUNITY_CARDS, MAX_PLAYERS
+#include "card_set.h"      // for card_set_t
+#include "range.h"         // for range_t
+
+/**
+ * @brief a spot to compute the equity of: the hole cards of every seat still in the
+ *        hand, the community cards known so far and any other cards known to be out
+ */
+typedef struct {
+    int num_players;                                // seats in hole_cards, between 2 and MAX_PLAYERS
+    card_t hole_cards[MAX_PLAYERS][HAND_SIZE];
+    card_t board[MAX_COMMUNITY_CARDS];
+    int num_board;                                  // 0 (preflop), 3, 4 or 5
+    card_set_t dead;                                // e.g. folded hands, burned cards
+} equity_query_t;
+
+/**
+ * @brief how much work a simulation may do
+ *
+ * it stops as soon as either limit is reached, 0 turns a limit off (but not both)
+ */
+typedef struct {
+    long samples;                                   // total runouts over all threads
+    double time_budget_ms;                          // wall clock budget
+    int num_threads;                                // 0 to use every online core
+    uint64_t seed;                                  // runs with the same seed and samples are repeatable
+} equity_config_t;
+
+typedef struct {
+    long samples;                                   // runouts actually evaluated
+    double win[MAX_PLAYERS];                        // fraction of runouts won outright
+    double tie[MAX_PLAYERS];                        // fraction of runouts split with someone
+    double equity[MAX_PLAYERS];                     // average share of the pot
+    double equity_ci95[MAX_PLAYERS];                // half width of the 95% confidence interval of equity
+} equity_result_t;
+
+typedef struct {
+    double equity;                                  // hero's average share of the pot
+    double combo_equity[RANGE_COMBOS];              // per hero combo, 0 for combos that never play
+    double matchups;                                // total weight of the (hero, villain, runout) matchups
+} range_equity_result_t;
+
+/**
+ * @brief estimates the equity of every seat by dealing random runouts of the board
+ *
+ * the runouts are split over a pool of worker threads, each with its own random stream
+ *
+ * @param query the hands, board and dead cards
+ * @param config the sample count and/or time budget
+ * @param out filled with the per seat results
+ * @return 0 on success, -1 if the query is invalid (duplicate cards, bad counts) or no limit is set
+ */
+int equity_monte_carlo(const equity_query_t *query, const equity_config_t *config, equity_result_t *out);
+
+/**
+ * @brief computes the exact equity of every seat by dealing every possible runout
+ *
+ * meant for spots where the board is at least partly out, e.g. everyone all in on the
+ * flop (at most C(45,2) = 990 runouts). the runouts are split into equal ranges, one per thread
+ *
+ * @param query the hands, board and dead cards
+ * @param num_threads the number of threads, 0 to use every online core
+ * @param out filled with the per seat results, the confidence intervals are 0
+ * @return 0 on success, -1 if the query is invalid
+ */
+int equity_exhaustive(const equity_query_t *query, int num_threads, equity_result_t *out);
+
+/**
+ * @brief computes the exact equity of one weighted range against another on a flop, turn or river
+ *
+ * every runout of the board is dealt, combos blocked by the board, the dead cards or the
+ * other hand are skipped, and every matchup counts with the product of the two weights.
+ * the runouts are split over the threads
+ *
+ * @param hero the range to compute the equity of
+ * @param villain the opposing range
+ * @param board the community cards, without NOCARD entries
+ * @param num_board 3, 4 or 5
+ * @param dead cards that neither range can hold and that cannot come on the board
+ * @param num_threads the number of threads, 0 to use every online core
+ * @param out filled with the overall and per combo equity
+ * @return 0 on success, -1 if the board is invalid, the ranges never meet or out of memory
+ */
+int equity_range_vs_range(const range_t *hero, const range_t *villain, const card_t *board, int num_board,
+                          card_set_t dead, int num_threads, range_equity_result_t *out);
+
+/**
+ * @brief fills a query with the seats still contesting the pot (active or all in) and
+ *        the community cards dealt so far
+ *
+ * @param seats filled with the seat of each query entry
+ * @return the number of seats in the query
+ */
+int equity_query_from_game(game_state_t *game, equity_query_t *query, player_id_t seats[MAX_PLAYERS]);
+
+#endif
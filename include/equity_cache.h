@@ -0,0 +1,74 @@
+#ifndef EQUITY_CACHE_H
+#define EQUITY_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "equity.h"
+
+/**
+ * memoizes equity results so that bots asking about the same spot again get a hash lookup
+ * instead of a fresh simulation
+ *
+ * spots are keyed by their suit canonical form: queries that only differ by a renaming of
+ * suits (AsKs vs QhQd on 2s7c8c is the same spot as AhKh vs QsQd on 2h7c8c) share an entry.
+ * the seats keep their order, so a cached result applies to the query as is.
+ *
+ * the entries are split over EQUITY_CACHE_SHARDS shards, each with its own lock, so threads
+ * looking up different spots rarely wait on each other. every shard holds a fixed number of
+ * entries and makes room with the CLOCK algorithm, an entry that was hit since the hand last
+ * swept past it gets another round.
+ */
+
+#define EQUITY_CACHE_SHARDS 16
+
+typedef struct equity_cache equity_cache_t;
+
+typedef struct {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    uint64_t entries;                               // entries currently stored
+    uint64_t capacity;                              // entries the cache can hold
+} equity_cache_stats_t;
+
+/**
+ * @brief creates a cache
+ *
+ * @param capacity the maximum number of entries, rounded up to a multiple of EQUITY_CACHE_SHARDS
+ * @return the cache, or NULL if out of memory
+ */
+equity_cache_t *equity_cache_create(size_t capacity);
+
+void equity_cache_destroy(equity_cache_t *cache);
+
+/**
+ * @brief equity_monte_carlo() behind the cache
+ *
+ * results are keyed on the spot and config->samples, the seed and thread count are not part
+ * of the key, any estimate with the same sample count is as good as another. runs with a
+ * time budget share one key of their own, they may stop before config->samples
+ *
+ * @return 0 on success, -1 if the query or config is invalid
+ */
+int equity_cache_monte_carlo(equity_cache_t *cache, const equity_query_t *query, const equity_config_t *config,
+                             equity_result_t *out);
+
+/**
+ * @brief equity_exhaustive() behind the cache
+ *
+ * @return 0 on success, -1 if the query is invalid
+ */
+int equity_cache_exhaustive(equity_cache_t *cache, const equity_query_t *query, int num_threads, equity_result_t *out);
+
+/**
+ * @brief adds up the counters of every shard
+ */
+void equity_cache_stats(equity_cache_t *cache, equity_cache_stats_t *out);
+
+/**
+ * @brief drops every entry and resets the counters
+ */
+void equity_cache_clear(equity_cache_t *cache);
+
+#endif
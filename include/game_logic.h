@@ -3,6 +3,9 @@
 
 #include "poker_client.h"  // for card_t, player_id_t
 #include "macros.h"        // for constants like MAX_PLAYERS
+#include "card_set.h"      // for card_set_t
+#include "hand_eval.h"     // for hand_eval_state_t
+#include "rng.h"           // for rng_t, rng_legacy_t
 
 #define MAX_COMMUNITY_CARDS 5
 #define HAND_SIZE 2
@@ -24,6 +27,34 @@ typedef enum {
     ROUND_SHOWDOWN = 6
 } round_stage_t;
 
+typedef enum {
+    DECK_RNG_LEGACY = 0,                           // rand() with its shuffle, the decks of the golden logs
+    DECK_RNG_XOSHIRO = 1,                          // xoshiro256** with an unbiased Fisher-Yates shuffle
+    DECK_RNG_LAZY = 2,                             // xoshiro256**, one Fisher-Yates step per card as it is drawn
+    DECK_RNG_COUNTER = 3                           // Philox, every deck a function of (seed, table, hand), see deal_deck
+} deck_rng_mode_t;
+
+// the generator a table shuffles with, owned by the table so tables never share a stream
+typedef struct {
+    deck_rng_mode_t mode;
+    union {
+        rng_legacy_t legacy;
+        rng_t xoshiro;                             // also the lazy mode
+        struct {
+            uint64_t seed;
+            uint32_t table;
+            uint64_t hand;                         // the next hand to deal
+        } counter;
+    };
+} deck_rng_t;
+
+typedef struct deck_queue deck_queue_t;
+
+// one bit per seat, bit i for seat i
+typedef uint32_t seat_mask_t;
+#define SEAT_BIT(seat) ((seat_mask_t) 1 << (seat))
+#define SEATS_BELOW(n) (SEAT_BIT(n) - 1)
+
 typedef struct {
     card_t player_hands[MAX_PLAYERS][HAND_SIZE];   // each player’s 2 cards
     card_t community_cards[MAX_COMMUNITY_CARDS];   // shared cards on table
@@ -39,22 +70,93 @@ typedef struct {
     round_stage_t round_stage;                     // init/preflop/flop/turn/river/showdown
     int num_players;                               // total players in game
     int sockets[MAX_PLAYERS];                      // sockets for each player
+    hand_eval_state_t hands_so_far[MAX_PLAYERS];   // each player's hole cards plus the community cards dealt so far
+    int hand_values[MAX_PLAYERS];                  // value of hands_so_far, updated every street
+    int community_dealt;                           // community cards added to hands_so_far
+    int street_actions;                            // actions taken this betting round
+    deck_rng_t rng;                                // shuffles the deck between hands
+    deck_queue_t *deck_queue;                      // decks shuffled ahead (see deck_queue.h), NULL to shuffle inline
+    seat_mask_t active_seats;                      // seats in PLAYER_ACTIVE, kept by set_player_status
+    seat_mask_t allin_seats;                       // seats in PLAYER_ALLIN
+    seat_mask_t left_seats;                        // seats in PLAYER_LEFT
+    seat_mask_t matched_seats;                     // seats whose current bet is the highest bet
 } game_state_t;
 
+static inline int seat_count(seat_mask_t mask)
+{
+    return __builtin_popcount(mask);
+}
+
+/**
+ * @brief the first seat of mask after seat after, wrapping around to the lowest seat
+ *
+ * @return the seat, or -1 if mask is empty
+ */
+static inline int next_seat(seat_mask_t mask, player_id_t after)
+{
+    seat_mask_t later = mask & ~SEATS_BELOW(after + 1);
+    if (later)
+        return __builtin_ctz(later);
+    return mask ? __builtin_ctz(mask) : -1;
+}
+
+// Seats live in the low bits of a ranking key, below the hand value
+#define RANKING_SEAT_BITS 3
+#define RANKING_SEAT_MASK ((1 << RANKING_SEAT_BITS) - 1)
+
+typedef struct {
+    int num_seats;                                 // live seats ranked
+    player_id_t order[MAX_PLAYERS];                // best hand first, equal hands by seat
+    int values[MAX_PLAYERS];                       // hand value of order[i]
+    int group[MAX_PLAYERS];                        // tie group of order[i], 0 for the winners
+    int num_groups;                                // number of distinct hand values
+    int group_start[MAX_PLAYERS + 1];              // group g is order[group_start[g]] .. order[group_start[g + 1] - 1]
+} hand_ranking_t;
+
+// Draws a seat holds after the flop or turn, see analyze_draws
+#define DRAW_FLUSH              (1 << 0)   // four cards of a suite
+#define DRAW_OPEN_ENDED         (1 << 1)   // two ranks complete a straight (also double gutshots)
+#define DRAW_GUTSHOT            (1 << 2)   // one rank completes a straight
+#define DRAW_BACKDOOR_FLUSH     (1 << 3)   // three cards of a suite on the flop
+#define DRAW_BACKDOOR_STRAIGHT  (1 << 4)   // three cards of a straight on the flop
+
+typedef struct {
+    int outs;                                      // unseen cards that put the hand in a better category
+    card_set_t out_cards;                          // those cards
+    int draws;                                     // DRAW_* flags
+} draw_info_t;
+
 void init_game_state(game_state_t *game, int starting_stack, int random_seed);
 void reset_game_state(game_state_t *game);
 void print_game_state(game_state_t *game); // for debugging
 void init_deck(card_t deck[DECK_SIZE], int seed); 
 void shuffle_deck(card_t deck[DECK_SIZE]);
+void deck_rng_seed(deck_rng_t *rng, deck_rng_mode_t mode, uint64_t seed); // legacy mode uses the low 32 bits like srand
+void deck_rng_shuffle(deck_rng_t *rng, card_t deck[DECK_SIZE]);           // shuffle_deck without the global rand() state
+card_t draw_card(game_state_t *game);                                     // the next card of the deck
+void deck_rng_seed_counter(deck_rng_t *rng, uint64_t seed, uint32_t table, uint64_t first_hand);
+void deal_deck(uint64_t seed, uint32_t table, uint64_t hand, card_t deck[DECK_SIZE]); // the deck of any hand in counter mode
+void set_player_status(game_state_t *game, player_id_t seat, player_status_t status); // keeps the seat masks in step
+void recount_seats(game_state_t *game);                                  // rebuilds the seat masks after writing the statuses or bets directly
+seat_mask_t funded_seats(const game_state_t *game);                      // seats not left with chips behind, the ones reset_game_state deals in
 int check_betting_end(game_state_t *game);
-int find_winner(game_state_t *game);
+int find_winner(game_state_t *game);                                      // the best active or all in seat, ties go to the lowest
 int evaluate_hand(game_state_t *game, player_id_t pid);
+int rank_hands(game_state_t *game, hand_ranking_t *ranking); // orders every active or all in seat by hand
+void analyze_draws(card_set_t hole, card_set_t board, draw_info_t *out); // outs and draws on a flop or turn
+int seat_draws(game_state_t *game, player_id_t pid, draw_info_t *out);  // analyze_draws for a seat, returns its outs
+card_set_t player_card_set(game_state_t *game, player_id_t pid);
+card_set_t board_card_set(game_state_t *game);
+
+void deal_hole_cards(game_state_t *game);
+void deal_community_card(game_state_t *game, int slot);
 
+// the server side of the engine (engine.h): the same hand played over the sockets
 void server_join(game_state_t *game);
 int server_ready(game_state_t *game);
-void server_deal(game_state_t *game);
+int server_deal(game_state_t *game);
 int server_bet(game_state_t *game);
 void server_community(game_state_t *game);
-void server_end(game_state_t *game);
+void server_end(game_state_t *game, player_id_t winner);
 
 #endif
@@ -0,0 +1,140 @@
+#ifndef HAND_EVAL_H
+#define HAND_EVAL_H
+
+#include "poker_client.h"  // for card_t
+#include "card_set.h"
+
+#include <stdint.h>
+
+/**
+ * hand values are totally ordered: a larger value is a stronger hand
+ *
+ * bits 20 and up hold the hand category, the lower 20 bits hold up to five
+ * ranks (4 bits each, most significant first) that break ties within a category
+ */
+
+typedef enum {
+    HAND_HIGH_CARD = 1,
+    HAND_ONE_PAIR = 2,
+    HAND_TWO_PAIR = 3,
+    HAND_TRIPS = 4,
+    HAND_STRAIGHT = 5,
+    HAND_FLUSH = 6,
+    HAND_FULL_HOUSE = 7,
+    HAND_QUADS = 8,
+    HAND_STRAIGHT_FLUSH = 9
+} hand_category_t;
+
+#define HAND_CATEGORY_SHIFT 20
+#define HAND_CATEGORY(value) ((value) >> HAND_CATEGORY_SHIFT)
+
+#define NUM_RANKS 13
+#define NUM_SUITES 4
+
+/**
+ * a hand that is built up one card at a time, e.g. hole cards first and then the board
+ * street by street. adding a card and reading the value are each a couple of table reads.
+ */
+typedef struct {
+    uint32_t state;                 // rank automaton state
+    int suit_masks[NUM_SUITES];     // ranks held in each suite
+} hand_eval_state_t;
+
+/**
+ * @brief builds the lookup tables used by the evaluator
+ *
+ * safe to call more than once and from several threads, only the first call does any work
+ */
+void hand_eval_init();
+
+/**
+ * @brief evaluates the best hand that can be made out of up to 7 cards
+ *
+ * @note hand_eval_init() must have been called first
+ * @param cards the cards to evaluate
+ * @param num_cards the number of cards, between 0 and 7
+ * @return the hand value. hands with fewer than 5 cards only score pairs, trips and quads
+ */
+int hand_eval_cards(const card_t *cards, int num_cards);
+
+/**
+ * @brief evaluates the best hand that can be made out of a set of up to 7 cards
+ *
+ * same values as hand_eval_cards, but flushes, straights and pairs are found with
+ * bit operations on the set instead of walking the cards one by one
+ *
+ * @note hand_eval_init() must have been called first
+ */
+int hand_eval_set(card_set_t set);
+
+/**
+ * @brief resets an incremental hand to no cards
+ */
+void hand_eval_state_init(hand_eval_state_t *hand);
+
+/**
+ * @brief adds one card to an incremental hand, at most 7 cards can be added
+ *
+ * @note hand_eval_init() must have been called first
+ */
+void hand_eval_state_add(hand_eval_state_t *hand, card_t card);
+
+/**
+ * @brief the value of the cards added so far, same as hand_eval_cards on those cards
+ */
+int hand_eval_state_value(const hand_eval_state_t *hand);
+
+/**
+ * fixed size evaluators
+ *
+ * the card count is part of the function, so the card loop is unrolled and nothing
+ * checks how many cards there are. the standard ones give the same values as
+ * hand_eval_cards.
+ *
+ * the short deck ones play the 36 card deck (six to ace, no card below the six may be
+ * passed): the ace also plays low in A-6-7-8-9 and a flush beats a full house. their
+ * values are only comparable with each other, and the flush and full house categories
+ * trade places in them, HAND_SHORT_DECK_CATEGORY reads the real category back.
+ *
+ * @note hand_eval_init() must have been called first
+ */
+int hand_eval_5(const card_t cards[5]);
+int hand_eval_6(const card_t cards[6]);
+int hand_eval_7(const card_t cards[7]);
+int hand_eval_short_5(const card_t cards[5]);
+int hand_eval_short_6(const card_t cards[6]);
+int hand_eval_short_7(const card_t cards[7]);
+
+#define HAND_SHORT_DECK_CATEGORY(value) \
+    (HAND_CATEGORY(value) == HAND_FLUSH ? HAND_FULL_HOUSE : \
+     HAND_CATEGORY(value) == HAND_FULL_HOUSE ? HAND_FLUSH : HAND_CATEGORY(value))
+
+/**
+ * @brief evaluates many complete 7 card hands in one call
+ *
+ * uses AVX2 when the cpu supports it (checked at runtime) and plain scalar code otherwise
+ *
+ * @note hand_eval_init() must have been called first
+ * @param hands num_hands * 7 cards, one hand after the other
+ * @param num_hands the number of hands
+ * @param values filled with the value of each hand
+ * @return the index of the strongest hand (the lowest index on ties), -1 if num_hands is 0
+ */
+int hand_eval_batch(const card_t *hands, int num_hands, int *values);
+
+/**
+ * @brief evaluates many pairs of hole cards against the same board in one call
+ *
+ * the board is only walked once, then every hand adds its 2 hole cards
+ *
+ * @note hand_eval_init() must have been called first
+ * @param hole_cards num_hands * 2 hole cards, one hand after the other
+ * @param num_hands the number of hands
+ * @param board the community cards, without NOCARD entries
+ * @param num_board the number of community cards, at most 5
+ * @param values filled with the value of each hand
+ * @return the index of the strongest hand (the lowest index on ties), -1 if num_hands is 0
+ */
+int hand_eval_batch_board(const card_t *hole_cards, int num_hands, const card_t *board, int num_board, int *values);
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef HAND_INDEX_H
+#define HAND_INDEX_H
+
+#include <stdint.h>
+
+#include "poker_client.h"  // for card_t
+
+/**
+ * suit isomorphic hand indexing
+ *
+ * two (hole cards, board) tuples are isomorphic if one turns into the other by renaming
+ * suits, e.g. AsKs on 2s7h9d plays exactly like AhKh on 2h7s9d. every class of isomorphic
+ * tuples of a street gets a dense index in [0, hand_index_size(street)), so tables keyed
+ * on spots can be plain arrays:
+ *
+ *  preflop     169
+ *  flop        1,286,792
+ *  turn        13,960,050
+ *  river       123,156,254
+ *
+ * only the split between hole cards and board matters, not the order the board was dealt in,
+ * which is all an equity or strength lookup needs.
+ */
+
+#define HAND_INDEX_PREFLOP  0
+#define HAND_INDEX_FLOP     1
+#define HAND_INDEX_TURN     2
+#define HAND_INDEX_RIVER    3
+#define HAND_INDEX_STREETS  4
+
+/**
+ * @brief builds the tables used by the indexer
+ *
+ * safe to call more than once and from several threads, only the first call does any work
+ */
+void hand_index_init();
+
+/**
+ * @brief the street of a board with num_board community cards (0, 3, 4 or 5), -1 for any other count
+ */
+int hand_index_street(int num_board);
+
+/**
+ * @brief the number of indices of a street
+ */
+uint64_t hand_index_size(int street);
+
+/**
+ * @brief the index of the class of a (hole cards, board) tuple
+ *
+ * @note hand_index_init() must have been called first
+ * @param hole the 2 hole cards
+ * @param board the community cards, without NOCARD entries
+ * @param num_board 0, 3, 4 or 5
+ * @return the index, or UINT64_MAX if num_board is not a street or a card is repeated
+ */
+uint64_t hand_index(const card_t hole[2], const card_t *board, int num_board);
+
+/**
+ * @brief writes the canonical representative of an index
+ *
+ * @note hand_index_init() must have been called first
+ * @param street the street the index belongs to
+ * @param index an index below hand_index_size(street)
+ * @param hole filled with the 2 hole cards
+ * @param board filled with the community cards of the street
+ * @return 0 on success, -1 if the index is out of range
+ */
+int hand_unindex(int street, uint64_t index, card_t hole[2], card_t *board);
+
+/**
+ * @brief replaces a tuple by the canonical representative of its class
+ *
+ * isomorphic tuples give the same output, cards within a round are sorted
+ *
+ * @return 0 on success, -1 on an invalid tuple
+ */
+int hand_canonicalize(const card_t hole[2], const card_t *board, int num_board, card_t hole_out[2], card_t *board_out);
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef HAND_STRENGTH_H
+#define HAND_STRENGTH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "poker_client.h"  // for card_t
+
+/**
+ * hand strength of a hand against one unknown opponent, for bots
+ *
+ * every opponent holding that does not clash with the known cards is equally likely.
+ * on top of the strength right now, the runouts of the board tell how often the hand
+ * gets better or worse by the river (the potentials) and how its river strength is
+ * spread out (the EHS² histogram).
+ *
+ * the runouts are split over a pool of threads. a spot is computed exactly by going
+ * over every runout, or estimated from random ones to bound the time of a decision.
+ */
+
+#define HS_BUCKETS 10
+
+typedef struct {
+    long runouts;                                   // random runouts to deal, 0 for every runout
+    double time_budget_ms;                          // wall clock budget, 0 for none (implies sampling)
+    int num_threads;                                // 0 to use every online core
+    uint64_t seed;                                  // runs with the same seed and runouts are repeatable
+} hand_strength_config_t;
+
+typedef struct {
+    long runouts;                                   // runouts actually dealt
+    double hs;                                      // chance to be ahead of a random hand now, ties count half
+    double ppot;                                    // chance to get ahead by the river when behind now
+    double npot;                                    // chance to fall behind by the river when ahead now
+    double ehs;                                     // hs * (1 - npot) + (1 - hs) * ppot
+    double ehs2;                                    // mean of the squared river hand strength
+    double histogram[HS_BUCKETS];                   // share of runouts by river hand strength, bucket b is [b, b + 1) / HS_BUCKETS
+} hand_strength_t;
+
+typedef struct hand_strength_cache hand_strength_cache_t;
+
+/**
+ * @brief computes the hand strength, potentials and river strength distribution of a hand
+ *
+ * before the flop there is no strength to compare to, hs is then the mean river strength
+ * and both potentials are 0
+ *
+ * @param hole the 2 hole cards
+ * @param board the community cards, without NOCARD entries
+ * @param num_board 0, 3, 4 or 5
+ * @param config how many runouts and how much time, NULL to go over every runout
+ * @param out filled with the result
+ * @return 0 on success, -1 on an invalid hand or board
+ */
+int hand_strength(const card_t hole[2], const card_t *board, int num_board, const hand_strength_config_t *config,
+                  hand_strength_t *out);
+
+/**
+ * @brief creates a cache with a fixed number of entries for each street
+ *
+ * spots are keyed by their suit isomorphic index (see hand_index.h), a new spot replaces
+ * whatever was in its slot
+ *
+ * @return the cache, or NULL if out of memory
+ */
+hand_strength_cache_t *hand_strength_cache_create(size_t entries_per_street);
+
+void hand_strength_cache_destroy(hand_strength_cache_t *cache);
+
+/**
+ * @brief hand_strength() behind the cache, results are reused for the same number of runouts
+ */
+int hand_strength_cached(hand_strength_cache_t *cache, const card_t hole[2], const card_t *board, int num_board,
+                         const hand_strength_config_t *config, hand_strength_t *out);
+
+/**
+ * @brief the number of lookups answered from the cache and computed
+ */
+void hand_strength_cache_counts(hand_strength_cache_t *cache, uint64_t *hits, uint64_t *misses);
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <stddef.h>
+#include <time.h>
+
+/**
+ * splitting work over threads, shared by the equity and hand strength modules and the
+ * drivers
+ *
+ * exhaustive runs number the runouts as the combinations of the missing board cards
+ * out of the remaining ones in lexicographic order. each worker gets a contiguous range
+ * of ranks (split_work), unranks the first one and steps through the rest with
+ * next_combination. sampling runs stop at a deadline taken with deadline_after.
+ */
+
+#define THREADS_PER_CORE 4                          // the most threads thread_count hands out per core
+#define MAX_THREADS 256                             // and overall, the worker arrays live on the stack
+
+/**
+ * @brief the number of online cores, at least 1
+ */
+int default_threads();
+
+/**
+ * @brief how many threads to split work items over
+ *
+ * @param requested the threads asked for, 0 or less for every online core
+ * @param work the number of items, a thread gets at least one. 0 when unknown (e.g. a
+ *        time budget)
+ * @return requested, capped at THREADS_PER_CORE per core, MAX_THREADS and work
+ */
+int thread_count(int requested, long work);
+
+/**
+ * @brief sets deadline to budget_ms milliseconds from now (CLOCK_MONOTONIC)
+ */
+void deadline_after(struct timespec *deadline, double budget_ms);
+
+/**
+ * @brief whether CLOCK_MONOTONIC has reached deadline
+ */
+int past_deadline(const struct timespec *deadline);
+
+/**
+ * @brief n choose k, 0 when k is out of range
+ */
+long choose(int n, int k);
+
+/**
+ * @brief the combination of k out of n at position rank in lexicographic order
+ */
+void unrank_combination(long rank, int n, int k, int *combo);
+
+/**
+ * @brief steps combo to the next combination of k out of n, the last one stays as it is
+ */
+void next_combination(int n, int k, int *combo);
+
+/**
+ * @brief the share of part out of parts of total items: contiguous ranges of (almost)
+ *        equal size, the first total % parts of them one item longer
+ */
+void split_work(long total, int parts, int part, long *first, long *count);
+
+/**
+ * @brief runs work on every one of num_workers workers of size bytes each, returns once
+ *        all of them are done
+ *
+ * the calling thread works too, as the last worker. a worker that cannot get a thread
+ * of its own is run inline.
+ */
+void run_workers(void *(*work)(void *), void *workers, size_t size, int num_workers);
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef PLATFORM_H
+#define PLATFORM_H
+
+/**
+ * what the modules that care about the machine or the build share
+ */
+
+// per thread state is aligned (and padded) to this so two threads never share a line
+#define CACHE_LINE 64
+
+// the optimization level, passed by the makefile for the perf.% builds. the drivers
+// report it with their numbers since -O0 figures are not comparable
+#ifndef OPT_LEVEL
+#ifdef __OPTIMIZE__
+#define OPT_LEVEL "optimized"
+#else
+#define OPT_LEVEL "-O0"
+#endif
+#endif
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef PREFLOP_TABLE_H
+#define PREFLOP_TABLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "poker_client.h"  // for card_t, MAX_PLAYERS
+
+/**
+ * canonical preflop hands
+ *
+ * the 1326 starting hands fall into 169 classes that only differ by suit: 13 pairs,
+ * 78 suited and 78 offsuit hands. a class is laid out on a 13x13 grid:
+ *  - pairs on the diagonal             [rank][rank]
+ *  - suited hands above it             [high][low]
+ *  - offsuit hands below it            [low][high]
+ * and its index is row * 13 + column
+ */
+
+#define PREFLOP_CLASSES 169
+
+#define PREFLOP_TABLE_MAGIC "PFEQTBL"
+#define PREFLOP_TABLE_VERSION 1
+#define PREFLOP_TABLE_PATH "build/preflop_equity.bin"
+
+/**
+ * the file starts with this header, followed by (at the given byte offsets)
+ *  - float heads_up[169][169]                   equity of the row class against the column class
+ *  - float multiway[MAX_PLAYERS - 1][169]       equity of a class against 1 .. MAX_PLAYERS - 1 random hands
+ * all values are stored in the native byte order of the machine that generated them
+ */
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t num_classes;
+    uint32_t max_players;
+    uint32_t samples;               // runouts per entry used by the generator
+    uint64_t heads_up_offset;
+    uint64_t multiway_offset;
+} preflop_table_header_t;
+
+typedef struct {
+    const void *data;               // the whole mapped file
+    size_t size;
+    const float *heads_up;
+    const float *multiway;
+} preflop_table_t;
+
+/**
+ * @brief the class index (0 - 168) of a starting hand
+ */
+int preflop_class(card_t a, card_t b);
+
+/**
+ * @brief maps a table file read only, so every process shares one copy in the page cache
+ *
+ * @param table filled with pointers into the mapping
+ * @param path the file written by the preflop_table make target, e.g. PREFLOP_TABLE_PATH
+ * @return 0 on success, -1 if the file is missing, truncated or of another version
+ */
+int preflop_table_open(preflop_table_t *table, const char *path);
+
+/**
+ * @brief unmaps a table opened with preflop_table_open
+ */
+void preflop_table_close(preflop_table_t *table);
+
+/**
+ * @brief heads up equity of hand (a0, a1) against hand (b0, b1), averaged over the suits of both classes
+ */
+static inline float preflop_equity(const preflop_table_t *table, card_t a0, card_t a1, card_t b0, card_t b1)
+{
+    return table->heads_up[preflop_class(a0, a1) * PREFLOP_CLASSES + preflop_class(b0, b1)];
+}
+
+/**
+ * @brief equity of hand (a0, a1) against num_players - 1 random hands, num_players between 2 and MAX_PLAYERS
+ */
+static inline float preflop_equity_multiway(const preflop_table_t *table, card_t a0, card_t a1, int num_players)
+{
+    return table->multiway[(num_players - 2) * PREFLOP_CLASSES + preflop_class(a0, a1)];
+}
+
+#endif
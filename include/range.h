@@ -0,0 +1,59 @@
+#ifndef RANGE_H
+#define RANGE_H
+
+#include "poker_client.h"  // for card_t
+#include "card_set.h"      // for card_set_t
+
+/**
+ * a weighted hand range
+ *
+ * every one of the 1326 two card combos has a weight, stored densely by combo index.
+ * for the cards lo < hi the index is hi * (hi - 1) / 2 + lo
+ */
+
+#define RANGE_COMBOS 1326
+
+typedef struct {
+    float weight[RANGE_COMBOS];
+} range_t;
+
+static inline int range_combo_index(card_t a, card_t b)
+{
+    card_t hi = a > b ? a : b;
+    card_t lo = a > b ? b : a;
+    return hi * (hi - 1) / 2 + lo;
+}
+
+/**
+ * @brief the two cards of a combo, lo < hi
+ */
+void range_combo_cards(int index, card_t *lo, card_t *hi);
+
+/**
+ * @brief the two cards of a combo as a card set, e.g. to test it against the board
+ */
+card_set_t range_combo_mask(int index);
+
+void range_clear(range_t *range);
+
+/**
+ * @brief sets the weight of one combo
+ */
+void range_set_hand(range_t *range, card_t a, card_t b, float weight);
+
+/**
+ * @brief sets the weight of every combo of a canonical preflop class (see preflop_table.h)
+ */
+void range_set_class(range_t *range, int preflop_class, float weight);
+
+/**
+ * @brief sets the weight of every combo that uses one of the cards to 0
+ */
+void range_remove_blocked(range_t *range, card_set_t cards);
+
+/**
+ * @brief the sum of all weights
+ */
+double range_total_weight(const range_t *range);
+
+#endif
@@ -0,0 +1,197 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+/**
+ * xoshiro256** random number generator
+ *
+ * the whole state lives in the struct, so every thread (or table) can own an
+ * independent stream instead of sharing the hidden state behind rand()
+ */
+
+typedef struct {
+    uint64_t s[4];
+} rng_t;
+
+static inline uint64_t splitmix64(uint64_t *x)
+{
+    uint64_t z = (*x += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+static inline uint64_t rng_rotl(uint64_t x, int k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
+/**
+ * @brief seeds the generator, different seeds give unrelated streams
+ */
+static inline void rng_seed(rng_t *rng, uint64_t seed)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        rng->s[i] = splitmix64(&seed);
+    }
+}
+
+static inline uint64_t rng_next(rng_t *rng)
+{
+    uint64_t *s = rng->s;
+    uint64_t result = rng_rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rng_rotl(s[3], 45);
+
+    return result;
+}
+
+/**
+ * @brief a uniform number in [0, bound), bound must be at least 1
+ */
+static inline uint32_t rng_below(rng_t *rng, uint32_t bound)
+{
+    // multiply-shift, the bias is below 2^-32 for the bounds used here (at most a deck)
+    return (uint32_t) (((rng_next(rng) >> 32) * (uint64_t) bound) >> 32);
+}
+
+/**
+ * the generator behind glibc srand()/rand() (TYPE_3, an additive feedback generator
+ * over the last 31 outputs), held in a struct
+ *
+ * seeded with the same value it returns exactly what rand() would, so decks shuffled
+ * with it match the ones dealt before tables owned their generator
+ */
+
+#define RNG_LEGACY_DEGREE 31
+#define RNG_LEGACY_SEPARATION 3
+#define RNG_LEGACY_DISCARD (10 * RNG_LEGACY_DEGREE)
+
+typedef struct {
+    uint32_t r[RNG_LEGACY_DEGREE];                  // the last 31 words, a ring indexed by pos
+    int pos;                                        // oldest word, the next one to be replaced
+} rng_legacy_t;
+
+static inline int rng_legacy_next(rng_legacy_t *rng)
+{
+    int front = rng->pos;
+    int rear = (front + RNG_LEGACY_DEGREE - RNG_LEGACY_SEPARATION) % RNG_LEGACY_DEGREE;
+    rng->r[front] += rng->r[rear];
+    rng->pos = (front + 1) % RNG_LEGACY_DEGREE;
+    return (int) (rng->r[front] >> 1);
+}
+
+/**
+ * @brief seeds the generator like srand(seed)
+ */
+static inline void rng_legacy_seed(rng_legacy_t *rng, unsigned int seed)
+{
+    // a Lehmer generator fills the first words, 0 would fill them all with 0
+    int32_t word = seed ? (int32_t) seed : 1;
+    rng->r[0] = word;
+    for (int i = 1; i < RNG_LEGACY_DEGREE; i++)
+    {
+        int32_t hi = word / 127773;
+        int32_t lo = word % 127773;
+        word = 16807 * lo - 2836 * hi;
+        if (word < 0)
+            word += 2147483647;
+        rng->r[i] = word;
+    }
+
+    // the ring starts with the separation already behind it
+    rng->pos = RNG_LEGACY_SEPARATION;
+    for (int i = 0; i < RNG_LEGACY_DISCARD; i++)
+    {
+        rng_legacy_next(rng);
+    }
+}
+
+/**
+ * Philox4x32-10 counter based generator
+ *
+ * a keyed bijection of a 128 bit counter, so the numbers at any position of a stream
+ * come straight from the key and the position without generating the ones before
+ */
+
+#define PHILOX_M0 0xd2511f53u
+#define PHILOX_M1 0xcd9e8d57u
+#define PHILOX_W0 0x9e3779b9u
+#define PHILOX_W1 0xbb67ae85u
+#define PHILOX_ROUNDS 10
+
+typedef struct {
+    uint32_t key[2];
+    uint32_t counter[4];                            // the next block, counter[0] counts up
+    uint32_t block[4];                              // the current block
+    int used;                                       // words of block handed out, 4 when it is spent
+} rng_counter_t;
+
+/**
+ * @brief the 4 words at counter in the stream of key
+ */
+static inline void philox4x32(const uint32_t counter[4], const uint32_t key[2], uint32_t out[4])
+{
+    uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+    uint32_t k0 = key[0], k1 = key[1];
+    for (int r = 0; r < PHILOX_ROUNDS; r++)
+    {
+        uint64_t p0 = (uint64_t) PHILOX_M0 * c0;
+        uint64_t p1 = (uint64_t) PHILOX_M1 * c2;
+        c0 = (uint32_t) (p1 >> 32) ^ c1 ^ k0;
+        c1 = (uint32_t) p1;
+        c2 = (uint32_t) (p0 >> 32) ^ c3 ^ k1;
+        c3 = (uint32_t) p0;
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+    out[0] = c0;
+    out[1] = c1;
+    out[2] = c2;
+    out[3] = c3;
+}
+
+/**
+ * @brief starts the stream of seed at the block (0, a, b, c), different (a, b, c) give
+ * independent streams
+ */
+static inline void rng_counter_init(rng_counter_t *rng, uint64_t seed, uint32_t a, uint32_t b, uint32_t c)
+{
+    rng->key[0] = (uint32_t) seed;
+    rng->key[1] = (uint32_t) (seed >> 32);
+    rng->counter[0] = 0;
+    rng->counter[1] = a;
+    rng->counter[2] = b;
+    rng->counter[3] = c;
+    rng->used = 4;
+}
+
+static inline uint32_t rng_counter_next(rng_counter_t *rng)
+{
+    if (rng->used == 4)
+    {
+        philox4x32(rng->counter, rng->key, rng->block);
+        rng->counter[0]++;
+        rng->used = 0;
+    }
+    return rng->block[rng->used++];
+}
+
+/**
+ * @brief a uniform number in [0, bound), bound must be at least 1
+ */
+static inline uint32_t rng_counter_below(rng_counter_t *rng, uint32_t bound)
+{
+    // multiply-shift, the bias is below bound / 2^32
+    return (uint32_t) (((uint64_t) rng_counter_next(rng) * bound) >> 32);
+}
+
+#endif
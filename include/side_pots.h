@@ -0,0 +1,42 @@
+#ifndef SIDE_POTS_H
+#define SIDE_POTS_H
+
+#include "game_logic.h"
+
+/**
+ * the pots of a hand once some seats are all in
+ *
+ * current_bets hold what every seat put in over the whole hand, so they are the
+ * contributions. every distinct contribution of a seat still in the hand (active or
+ * all in) closes a pot: pot p holds, from every seat, the chips between the previous
+ * level and its own, and only the seats still in that reached its level can win it.
+ * chips above the highest of those levels (a bet that was folded to) go to the last pot.
+ * without any all in there is a single pot, the whole of pot_size.
+ */
+
+typedef struct {
+    int num_pots;                                  // main pot first, then the side pots
+    int amounts[MAX_PLAYERS];                      // chips in pot p
+    seat_mask_t eligible[MAX_PLAYERS];             // seats that can win pot p
+    int payouts[MAX_PLAYERS];                      // what every seat collects, filled by award_side_pots
+    player_id_t main_winner;                       // first winner of the main pot, the best hand if there is no pot
+} side_pots_t;
+
+/**
+ * @brief splits the contributions of a hand into pots, payouts are cleared
+ *
+ * @return the number of pots, 0 if nobody bet
+ */
+int build_side_pots(const game_state_t *game, side_pots_t *pots);
+
+/**
+ * @brief awards every pot to the best hands among its eligible seats, fills payouts
+ *
+ * the seats are ranked once (rank_hands), each pot then goes to the first tie group
+ * holding an eligible seat. a pot split between several seats gives its odd chips to
+ * the lowest of them. without any pot (a hand checked down) main_winner is still the
+ * best hand. stacks are left as they are.
+ */
+void award_side_pots(game_state_t *game, side_pots_t *pots);
+
+#endif
@@ -0,0 +1,588 @@
+/**
+ * microbenchmarks for the hot paths of the server
+ *
+ * usage: server.bench [OUTPUT] [ITERATIONS] [SEED]
+ *
+ * every benchmark runs ITERATIONS operations (default 200000) over a pool of random
+ * inputs drawn from SEED, so two runs with the same arguments do the same work. each
+ * one is repeated a few times and the fastest repetition is reported as ns/op,
+ * operations per second and cycles per op (time stamp counter ticks, 0 where there
+ * is no counter). the results are printed and, if OUTPUT is given, written as JSON
+ * to track regressions between releases. make bench builds it with optimizations, the
+ * level is reported with the results since -O0 numbers are not comparable.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "game_logic.h"
+#include "client_action_handler.h"
+#include "hand_eval.h"
+#include "hand_index.h"
+#include "card_set.h"
+#include "rng.h"
+#include "deck_queue.h"
+#include "compact_table.h"
+#include "hand_strength.h"
+#include "platform.h"
+
+#define DEFAULT_ITERATIONS 200000
+#define DEFAULT_SEED 0x62656e6368ULL
+#define REPETITIONS 5
+#define NUM_INPUTS 256                  // a power of two, inputs are picked with a mask
+#define INPUT_MASK (NUM_INPUTS - 1)
+#define BATCH_HANDS 64
+#define STRENGTH_ITERATIONS 256         // iterations per hand_strength call, one call values every opponent
+#define SHARED_TABLES 4                 // tables on one deck producer in deal_hand_shared
+
+typedef struct {
+    const char *name;
+    long (*run)(long iterations);       // returns a checksum so the work cannot be optimized away
+    int ops_per_call;                   // operations done by one iteration
+    int iterations_per_op;              // for slow operations, done once every that many iterations (0 for 1)
+} benchmark_t;
+
+typedef struct {
+    double ns_per_op;
+    double ops_per_sec;
+    double cycles_per_op;
+} bench_result_t;
+
+static game_state_t river_games[NUM_INPUTS];
+static game_state_t flop_games[NUM_INPUTS];
+static card_t hands_7[NUM_INPUTS][7];
+static card_set_t sets_7[NUM_INPUTS];
+static card_t batch_hands[NUM_INPUTS][BATCH_HANDS * 7];
+
+static volatile long sink;
+
+static uint64_t read_cycles()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static double now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void shuffle_with(rng_t *rng, card_t deck[DECK_SIZE])
+{
+    for (int i = DECK_SIZE - 1; i > 0; i--)
+    {
+        int j = rng_below(rng, i + 1);
+        card_t temp = deck[i];
+        deck[i] = deck[j];
+        deck[j] = temp;
+    }
+}
+
+// a full table dealt from a random deck, with board_cards community cards out
+static void deal_game(rng_t *rng, game_state_t *game, int board_cards)
+{
+    init_game_state(game, 1000, 0);
+    shuffle_with(rng, game->deck);
+
+    game->round_stage = ROUND_PREFLOP + (board_cards ? board_cards - 2 : 0);
+    game->pot_size = rng_below(rng, 500);
+    game->dealer_player = rng_below(rng, MAX_PLAYERS);
+    game->current_player = rng_below(rng, MAX_PLAYERS);
+
+    // what deal_hole_cards does, minus the hidden board
+    for (int i = 0; i < game->num_players; i++)
+    {
+        hand_eval_state_init(&game->hands_so_far[i]);
+        for (int j = 0; j < HAND_SIZE; j++)
+        {
+            game->player_hands[i][j] = game->deck[game->next_card++];
+            hand_eval_state_add(&game->hands_so_far[i], game->player_hands[i][j]);
+        }
+        game->current_bets[i] = rng_below(rng, 100);
+    }
+    for (int i = 0; i < MAX_COMMUNITY_CARDS; i++)
+    {
+        game->community_cards[i] = NOCARD;
+    }
+    for (int i = 0; i < board_cards; i++)
+    {
+        deal_community_card(game, i);
+    }
+    recount_seats(game);
+}
+
+static void setup_inputs(uint64_t seed)
+{
+    rng_t rng;
+    rng_seed(&rng, seed);
+
+    for (int n = 0; n < NUM_INPUTS; n++)
+    {
+        deal_game(&rng, &river_games[n], 5);
+        deal_game(&rng, &flop_games[n], 3);
+
+        card_t deck[DECK_SIZE];
+        for (int i = 0; i < DECK_SIZE; i++)
+        {
+            deck[i] = i;
+        }
+        shuffle_with(&rng, deck);
+        memcpy(hands_7[n], deck, sizeof(hands_7[n]));
+        sets_7[n] = card_set_from_cards(hands_7[n], 7);
+
+        for (int h = 0; h < BATCH_HANDS; h++)
+        {
+            shuffle_with(&rng, deck);
+            memcpy(&batch_hands[n][h * 7], deck, 7 * sizeof(card_t));
+        }
+    }
+}
+
+// ------------------------------- benchmarks ------------------------------- //
+
+static long bench_evaluate_hand(long iterations)
+{
+    long sum = 0;
+    for (long i = 0; i < iterations; i++)
+    {
+        sum += evaluate_hand(&river_games[i & INPUT_MASK], i % MAX_PLAYERS);
+    }
+    return sum;
+}
+
+static long bench_find_winner_river(long iterations)
+{
+    long sum = 0;
+    for (long i = 0; i < iterations; i++)
+    {
+        sum += find_winner(&river_games[i & INPUT_MASK]);
+    }
+    return sum;
+}
+
+static long bench_find_winner_flop(long iterations)
+{
+    long sum = 0;
+    for (long i = 0; i < iterations; i++)
+    {
+        sum += find_winner(&flop_games[i & INPUT_MASK]);
+    }
+    return sum;
+}
+
+static long bench_rank_hands(long iterations)
+{
+    long sum = 0;
+    hand_ranking_t ranking;
+    for (long i = 0; i < iterations; i++)
+    {
+        rank_hands(&river_games[i & INPUT_MASK], &ranking);
+        sum += ranking.order[0] + ranking.num_groups;
+    }
+    return sum;
+}
+
+static long bench_shuffle_deck(long iterations)
+{
+    card_t deck[DECK_SIZE];
+    init_deck(deck, (int) iterations);
+    for (long i = 0; i < iterations; i++)
+    {
+        shuffle_deck(deck);
+    }
+    return deck[0];
+}
+
+static long bench_deck_rng_shuffle(deck_rng_mode_t mode, long iterations)
+{
+    card_t deck[DECK_SIZE];
+    deck_rng_t rng;
+    for (int i = 0; i < DECK_SIZE; i++)
+    {
+        deck[i] = i;
+    }
+    deck_rng_seed(&rng, mode, (uint64_t) iterations);
+    for (long i = 0; i < iterations; i++)
+    {
+        deck_rng_shuffle(&rng, deck);
+    }
+    return deck[0];
+}
+
+static long bench_shuffle_legacy(long iterations)
+{
+    return bench_deck_rng_shuffle(DECK_RNG_LEGACY, iterations);
+}
+
+static long bench_shuffle_xoshiro(long iterations)
+{
+    return bench_deck_rng_shuffle(DECK_RNG_XOSHIRO, iterations);
+}
+
+// a full 6 handed hand dealt the way the engine deals it: the hole cards, then the board
+// card by card, from a table shuffling in the given mode
+static long deal_hand(game_state_t *game)
+{
+    reset_game_state(game);
+    deal_hole_cards(game);
+    for (int c = 0; c < MAX_COMMUNITY_CARDS; c++)
+    {
+        deal_community_card(game, c);
+    }
+    return game->player_hands[0][0] + game->community_cards[MAX_COMMUNITY_CARDS - 1];
+}
+
+// queued 0 shuffles inline, 1 gives the table a producer of its own and more has that
+// many tables take turns on one shared producer
+static long bench_deal_hand(deck_rng_mode_t mode, int queued, long iterations)
+{
+    static game_state_t games[SHARED_TABLES];
+    int num_tables = queued > 1 ? queued : 1;
+    deck_producer_t *producer = NULL;
+    if (queued > 1 && !(producer = deck_producer_start()))
+        return 0;
+
+    for (int t = 0; t < num_tables; t++)
+    {
+        init_game_state(&games[t], 1000, 0);
+        deck_rng_seed(&games[t].rng, mode, (uint64_t) iterations + t);
+        if (queued)
+            deck_queue_attach(&games[t], producer, DECK_QUEUE_DEFAULT_DEPTH);
+    }
+
+    long sum = 0;
+    for (long i = 0; i < iterations; i++)
+    {
+        sum += deal_hand(&games[i % num_tables]);
+    }
+
+    for (int t = 0; t < num_tables; t++)
+    {
+        deck_queue_detach(&games[t]);
+    }
+    if (producer)
+        deck_producer_stop(producer);
+    return sum;
+}
+
+static long bench_deal_deck_counter(long iterations)
+{
+    card_t deck[DECK_SIZE];
+    long sum = 0;
+    for (long i = 0; i < iterations; i++)
+    {
+        deal_deck(DEFAULT_SEED, (uint32_t) (i & INPUT_MASK), (uint64_t) i, deck);
+        sum += deck[0];
+    }
+    return sum;
+}
+
+static long bench_deal_hand_xoshiro(long iterations)
+{
+    return bench_deal_hand(DECK_RNG_XOSHIRO, 0, iterations);
+}
+
+static long bench_deal_hand_queued(long iterations)
+{
+    return bench_deal_hand(DECK_RNG_XOSHIRO, 1, iterations);
+}
+
+static long bench_deal_hand_shared(long iterations)
+{
+    return bench_deal_hand(DECK_RNG_XOSHIRO, SHARED_TABLES, iterations);
+}
+
+static long bench_deal_hand_lazy(long iterations)
+{
+    return bench_deal_hand(DECK_RNG_LAZY, 0, iterations);
+}
+
+static long bench_build_info_packet(long iterations)
+{
+    long sum = 0;
+    server_packet_t packet;
+    for (long i = 0; i < iterations; i++)
+    {
+        build_info_packet(&river_games[i & INPUT_MASK], i % MAX_PLAYERS, &packet);
+        sum += packet.info.player_cards[0];
+    }
+    return sum;
+}
+
+static long bench_build_end_packet(long iterations)
+{
+    long sum = 0;
+    server_packet_t packet;
+    for (long i = 0; i < iterations; i++)
+    {
+        build_end_packet(&river_games[i & INPUT_MASK], i % MAX_PLAYERS, &packet);
+        sum += packet.end.winner;
+    }
+    return sum;
+}
+
+static long bench_table_pack(long iterations)
+{
+    static compact_table_t table;
+    static compact_table_cold_t cold;
+    long sum = 0;
+    for (long i = 0; i < iterations; i++)
+    {
+        compact_table_pack(&river_games[i & INPUT_MASK], &table, &cold);
+        sum += table.pot_size;
+    }
+    return sum;
+}
+
+static long bench_table_unpack(long iterations)
+{
+    static compact_table_t tables[NUM_INPUTS];
+    static compact_table_cold_t colds[NUM_INPUTS];
+    static game_state_t game;
+    for (int n = 0; n < NUM_INPUTS; n++)
+    {
+        compact_table_pack(&river_games[n], &tables[n], &colds[n]);
+    }
+
+    long sum = 0;
+    for (long i = 0; i < iterations; i++)
+    {
+        compact_table_unpack(&tables[i & INPUT_MASK], &colds[i & INPUT_MASK], &game);
+        sum += game.hand_values[0];
+    }
+    return sum;
+}
+
+static long bench_hand_eval_cards(long iterations)
+{
+    long sum = 0;
+    for (long i = 0; i < iterations; i++)
+    {
+        sum += hand_eval_cards(hands_7[i & INPUT_MASK], 7);
+    }
+    return sum;
+}
+
+static long bench_hand_eval_7(long iterations)
+{
+    long sum = 0;
+    for (long i = 0; i < iterations; i++)
+    {
+        sum += hand_eval_7(hands_7[i & INPUT_MASK]);
+    }
+    return sum;
+}
+
+static long bench_hand_eval_set(long iterations)
+{
+    long sum = 0;
+    for (long i = 0; i < iterations; i++)
+    {
+        sum += hand_eval_set(sets_7[i & INPUT_MASK]);
+    }
+    return sum;
+}
+
+static long bench_hand_eval_batch(long iterations)
+{
+    long sum = 0;
+    int values[BATCH_HANDS];
+    for (long i = 0; i < iterations; i++)
+    {
+        sum += hand_eval_batch(batch_hands[i & INPUT_MASK], BATCH_HANDS, values);
+    }
+    return sum;
+}
+
+static long bench_hand_index_river(long iterations)
+{
+    long sum = 0;
+    for (long i = 0; i < iterations; i++)
+    {
+        const card_t *cards = hands_7[i & INPUT_MASK];
+        sum += hand_index(cards, cards + 2, 5);
+    }
+    return sum;
+}
+
+static long bench_seat_draws(long iterations)
+{
+    long sum = 0;
+    draw_info_t draws;
+    for (long i = 0; i < iterations; i++)
+    {
+        sum += seat_draws(&flop_games[i & INPUT_MASK], i % MAX_PLAYERS, &draws);
+    }
+    return sum;
+}
+
+// exact hand strength of a river spot on the calling thread, every opponent holding once
+static long bench_hand_strength_river(long iterations)
+{
+    hand_strength_config_t config = { .num_threads = 1 };
+    hand_strength_t result;
+    long sum = 0;
+    for (long i = 0; i < iterations / STRENGTH_ITERATIONS; i++)
+    {
+        const card_t *cards = hands_7[i & INPUT_MASK];
+        hand_strength(cards, cards + 2, 5, &config, &result);
+        sum += (long) (result.hs * 1000);
+    }
+    return sum;
+}
+
+// the same spots answered from the cache, after a first pass filled it
+static long bench_hand_strength_cached(long iterations)
+{
+    static hand_strength_cache_t *cache;
+    if (!cache)
+        cache = hand_strength_cache_create(128 * NUM_INPUTS); // roomy enough that the inputs rarely share a slot
+    if (!cache)
+        return 0;
+
+    hand_strength_config_t config = { .num_threads = 1 };
+    hand_strength_t result;
+    long sum = 0;
+    for (long i = 0; i < iterations; i++)
+    {
+        const card_t *cards = hands_7[i & INPUT_MASK];
+        hand_strength_cached(cache, cards, cards + 2, 5, &config, &result);
+        sum += (long) (result.hs * 1000);
+    }
+    return sum;
+}
+
+static const benchmark_t benchmarks[] = {
+    { "evaluate_hand", bench_evaluate_hand, 1 },
+    { "find_winner_river", bench_find_winner_river, 1 },
+    { "find_winner_flop", bench_find_winner_flop, 1 },
+    { "rank_hands", bench_rank_hands, 1 },
+    { "shuffle_deck", bench_shuffle_deck, 1 },
+    { "shuffle_legacy", bench_shuffle_legacy, 1 },
+    { "shuffle_xoshiro", bench_shuffle_xoshiro, 1 },
+    { "deal_deck_counter", bench_deal_deck_counter, 1 },
+    { "deal_hand_xoshiro", bench_deal_hand_xoshiro, 1 },
+    { "deal_hand_lazy", bench_deal_hand_lazy, 1 },
+    { "deal_hand_queued", bench_deal_hand_queued, 1 },
+    { "deal_hand_shared", bench_deal_hand_shared, 1 },
+    { "build_info_packet", bench_build_info_packet, 1 },
+    { "build_end_packet", bench_build_end_packet, 1 },
+    { "table_pack", bench_table_pack, 1 },
+    { "table_unpack", bench_table_unpack, 1 },
+    { "hand_eval_cards", bench_hand_eval_cards, 1 },
+    { "hand_eval_7", bench_hand_eval_7, 1 },
+    { "hand_eval_set", bench_hand_eval_set, 1 },
+    { "hand_eval_batch", bench_hand_eval_batch, BATCH_HANDS },
+    { "hand_index_river", bench_hand_index_river, 1 },
+    { "seat_draws_flop", bench_seat_draws, 1 },
+    { "hand_strength_river", bench_hand_strength_river, 1, STRENGTH_ITERATIONS },
+    { "hand_strength_cached", bench_hand_strength_cached, 1 },
+};
+
+#define NUM_BENCHMARKS ((int) (sizeof(benchmarks) / sizeof(benchmarks[0])))
+
+static bench_result_t run_benchmark(const benchmark_t *bench, long iterations)
+{
+    // one untimed pass to warm up the caches and the branch predictors
+    sink += bench->run(iterations / 10 + 1);
+
+    double best_ns = -1, best_cycles = 0;
+    for (int r = 0; r < REPETITIONS; r++)
+    {
+        double start = now_ns();
+        uint64_t start_cycles = read_cycles();
+        sink += bench->run(iterations);
+        uint64_t cycles = read_cycles() - start_cycles;
+        double ns = now_ns() - start;
+
+        if (best_ns < 0 || ns < best_ns)
+        {
+            best_ns = ns;
+            best_cycles = (double) cycles;
+        }
+    }
+
+    double ops = (double) iterations * bench->ops_per_call;
+    if (bench->iterations_per_op > 1)
+        ops = (double) (iterations / bench->iterations_per_op) * bench->ops_per_call;
+    bench_result_t result = {
+        .ns_per_op = best_ns / ops,
+        .ops_per_sec = ops / (best_ns / 1e9),
+        .cycles_per_op = best_cycles / ops,
+    };
+    return result;
+}
+
+static int write_json(const char *path, long iterations, uint64_t seed, const bench_result_t *results)
+{
+    FILE *file = fopen(path, "w");
+    if (!file)
+        return -1;
+
+    fprintf(file, "{\n");
+    fprintf(file, "  \"iterations\": %ld,\n", iterations);
+    fprintf(file, "  \"seed\": %llu,\n", (unsigned long long) seed);
+    fprintf(file, "  \"repetitions\": %d,\n", REPETITIONS);
+    fprintf(file, "  \"optimization\": \"%s\",\n", OPT_LEVEL);
+    fprintf(file, "  \"benchmarks\": [\n");
+    for (int b = 0; b < NUM_BENCHMARKS; b++)
+    {
+        fprintf(file, "    {\"name\": \"%s\", \"ns_per_op\": %.3f, \"ops_per_sec\": %.0f, \"cycles_per_op\": %.1f}%s\n",
+                benchmarks[b].name, results[b].ns_per_op, results[b].ops_per_sec, results[b].cycles_per_op,
+                b + 1 < NUM_BENCHMARKS ? "," : "");
+    }
+    fprintf(file, "  ]\n");
+    fprintf(file, "}\n");
+
+    return fclose(file) == 0 ? 0 : -1;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 4)
+    {
+        fprintf(stderr, "usage: %s [OUTPUT] [ITERATIONS] [SEED]\n", argv[0]);
+        return 1;
+    }
+
+    const char *output = argc >= 2 ? argv[1] : NULL;
+    long iterations = argc >= 3 ? atol(argv[2]) : DEFAULT_ITERATIONS;
+    uint64_t seed = argc >= 4 ? strtoull(argv[3], NULL, 0) : DEFAULT_SEED;
+    if (iterations <= 0)
+    {
+        fprintf(stderr, "iterations must be positive.\n");
+        return 1;
+    }
+
+    hand_eval_init();
+    hand_index_init();
+    setup_inputs(seed);
+
+    bench_result_t results[NUM_BENCHMARKS];
+    printf("built with %s\n", OPT_LEVEL);
+    printf("%-20s %12s %14s %12s\n", "benchmark", "ns/op", "ops/s", "cycles/op");
+    for (int b = 0; b < NUM_BENCHMARKS; b++)
+    {
+        results[b] = run_benchmark(&benchmarks[b], iterations);
+        printf("%-20s %12.2f %14.0f %12.1f\n", benchmarks[b].name, results[b].ns_per_op,
+               results[b].ops_per_sec, results[b].cycles_per_op);
+    }
+
+    if (output && write_json(output, iterations, seed, results) == -1)
+    {
+        perror("write results");
+        return 1;
+    }
+    return 0;
+}
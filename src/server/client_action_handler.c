@@ -4,6 +4,7 @@
 
 #include "client_action_handler.h"
 #include "game_logic.h"
+#include "engine.h"
 
 /**
  * @brief Processes packet from client and generates a server response packet.
@@ -35,60 +36,13 @@ int handle_client_action(game_state_t *game, player_id_t pid, const client_packe
 
     memset(out, 0, sizeof(server_packet_t));
 
-    switch (in->packet_type)
+    engine_action_t action = { .type = in->packet_type, .amount = in->params[0] };
+    if (engine_bet(game, pid, &action) == -1)
     {
-    case CALL:
-    {
-        int to_call = game->highest_bet - game->current_bets[pid];
-        if (to_call < 0)
-            to_call = 0;
-        if (game->player_stacks[pid] < to_call)
-        {
-            out->packet_type = NACK;
-            return -1;
-        }
-        game->player_stacks[pid] -= to_call;
-        game->current_bets[pid] += to_call;
-        game->pot_size += to_call;
-        out->packet_type = ACK;
-        break;
-    }
-    case CHECK:
-    {
-        if (game->current_bets[pid] != game->highest_bet)
-        {
-            out->packet_type = NACK;
-            return -1;
-        }
-        out->packet_type = ACK;
-        break;
-    }
-    case RAISE:
-    {
-        int raise_amt = in->params[0];
-        int to_call = game->highest_bet - game->current_bets[pid] + raise_amt;
-        if (game->player_stacks[pid] < to_call)
-        {
-            out->packet_type = NACK;
-            return -1;
-        }
-        game->player_stacks[pid] -= to_call;
-        game->current_bets[pid] += to_call;
-        game->highest_bet += raise_amt;
-        game->pot_size += to_call;
-        out->packet_type = ACK;
-        break;
-    }
-    case FOLD:
-    {
-        game->player_status[pid] = PLAYER_FOLDED;
-        out->packet_type = ACK;
-        break;
-    }
-    default:
         out->packet_type = NACK;
         return -1;
     }
+    out->packet_type = ACK;
     return 0;
 }
 
@@ -0,0 +1,107 @@
+#include <string.h>
+
+#include "compact_table.h"
+
+static uint8_t pack_card(card_t card)
+{
+    return card == NOCARD ? COMPACT_NOCARD : (uint8_t) card;
+}
+
+void compact_table_pack(const game_state_t *game, compact_table_t *table, compact_table_cold_t *cold)
+{
+    memset(table, 0, sizeof(compact_table_t));
+    for (int i = 0; i < MAX_PLAYERS; i++)
+    {
+        table->player_stacks[i] = game->player_stacks[i];
+        table->current_bets[i] = game->current_bets[i];
+        table->player_status[i] = game->player_status[i];
+        table->hand_values[i] = game->hand_values[i];
+        for (int j = 0; j < HAND_SIZE; j++)
+        {
+            table->player_hands[i][j] = pack_card(game->player_hands[i][j]);
+        }
+    }
+    table->highest_bet = game->highest_bet;
+    table->pot_size = game->pot_size;
+    table->current_player = game->current_player;
+    table->round_stage = game->round_stage;
+
+    for (int i = 0; i < MAX_COMMUNITY_CARDS; i++)
+    {
+        table->community_cards[i] = pack_card(game->community_cards[i]);
+    }
+    table->dealer_player = game->dealer_player;
+    table->num_players = game->num_players;
+    table->next_card = game->next_card;
+    table->community_dealt = game->community_dealt;
+    table->street_actions = game->street_actions;
+
+    for (int i = 0; i < DECK_SIZE; i++)
+    {
+        cold->deck[i] = game->deck[i];
+    }
+    cold->rng = game->rng;
+    cold->deck_queue = game->deck_queue;
+    for (int i = 0; i < MAX_PLAYERS; i++)
+    {
+        cold->sockets[i] = game->sockets[i];
+    }
+}
+
+void compact_table_unpack(const compact_table_t *table, const compact_table_cold_t *cold, game_state_t *game)
+{
+    memset(game, 0, sizeof(game_state_t));
+    for (int i = 0; i < MAX_PLAYERS; i++)
+    {
+        game->player_stacks[i] = table->player_stacks[i];
+        game->current_bets[i] = table->current_bets[i];
+        game->player_status[i] = table->player_status[i];
+        game->hand_values[i] = table->hand_values[i];
+        for (int j = 0; j < HAND_SIZE; j++)
+        {
+            game->player_hands[i][j] = compact_card(table->player_hands[i][j]);
+        }
+    }
+    game->highest_bet = table->highest_bet;
+    game->pot_size = table->pot_size;
+    game->current_player = table->current_player;
+    game->round_stage = table->round_stage;
+
+    for (int i = 0; i < MAX_COMMUNITY_CARDS; i++)
+    {
+        game->community_cards[i] = compact_card(table->community_cards[i]);
+    }
+    game->dealer_player = table->dealer_player;
+    game->num_players = table->num_players;
+    game->next_card = table->next_card;
+    game->community_dealt = table->community_dealt;
+    game->street_actions = table->street_actions;
+
+    for (int i = 0; i < DECK_SIZE; i++)
+    {
+        game->deck[i] = cold->deck[i];
+    }
+    game->rng = cold->rng;
+    game->deck_queue = cold->deck_queue;
+    for (int i = 0; i < MAX_PLAYERS; i++)
+    {
+        game->sockets[i] = cold->sockets[i];
+    }
+    recount_seats(game);
+
+    // the hole cards plus the board dealt so far, the values were packed as they were
+    // (seats that sat out the deal only count once they play again, they are not read)
+    for (int i = 0; i < game->num_players; i++)
+    {
+        hand_eval_state_init(&game->hands_so_far[i]);
+        for (int j = 0; j < HAND_SIZE; j++)
+        {
+            if (game->player_hands[i][j] != NOCARD)
+                hand_eval_state_add(&game->hands_so_far[i], game->player_hands[i][j]);
+        }
+        for (int j = 0; j < game->community_dealt; j++)
+        {
+            hand_eval_state_add(&game->hands_so_far[i], game->community_cards[j]);
+        }
+    }
+}
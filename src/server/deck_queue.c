@@ -0,0 +1,272 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "deck_queue.h"
+#include "platform.h"
+
+typedef struct {
+    card_t deck[DECK_SIZE];
+    deck_rng_t rng;                                 // the generator right after shuffling deck
+} deck_slot_t;
+
+struct deck_queue {
+    // written by the consumer only
+    _Atomic uint64_t head __attribute__((aligned(CACHE_LINE)));
+    // written by the producer only
+    _Atomic uint64_t tail __attribute__((aligned(CACHE_LINE)));
+    // set by the consumer, cleared by the producer
+    atomic_int asked __attribute__((aligned(CACHE_LINE)));  // the ring drained to its low water mark
+    atomic_int waiting;                             // the consumer sleeps on ready for an empty ring
+
+    // owned by the producer
+    card_t deck[DECK_SIZE];
+    deck_rng_t rng;
+
+    deck_producer_t *producer;
+    int owns_producer;                              // started by deck_queue_attach for this table
+    pthread_cond_t ready;
+    int depth;
+    int low_water;
+    deck_slot_t *slots;
+};
+
+struct deck_producer {
+    pthread_mutex_t lock;
+    pthread_cond_t work;                            // the producer sleeps on it
+    pthread_cond_t idle;                            // detach waits on it for the producer to leave a queue
+    int wake;                                       // a ring wants filling since the last pass
+    int stop;
+    deck_queue_t *queues[DECK_PRODUCER_MAX_TABLES];
+    int num_queues;
+    deck_queue_t *busy;                             // the queue being filled outside the lock
+    pthread_t thread;
+};
+
+static void wake_producer(deck_producer_t *producer)
+{
+    pthread_mutex_lock(&producer->lock);
+    producer->wake = 1;
+    pthread_cond_signal(&producer->work);
+    pthread_mutex_unlock(&producer->lock);
+}
+
+// fills the free part of a ring, waking its table if it sleeps on the empty ring. asked
+// is cleared before the head is read, so a table draining the ring from here on asks again
+static void fill_queue(deck_queue_t *queue)
+{
+    atomic_store(&queue->asked, 0);
+    uint64_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    uint64_t head = atomic_load(&queue->head);
+
+    for (; tail - head < (uint64_t) queue->depth; tail++)
+    {
+        deck_slot_t *slot = &queue->slots[tail % queue->depth];
+        deck_rng_shuffle(&queue->rng, queue->deck);
+        memcpy(slot->deck, queue->deck, sizeof(slot->deck));
+        slot->rng = queue->rng;
+        atomic_store(&queue->tail, tail + 1);
+
+        if (atomic_load(&queue->waiting))
+        {
+            pthread_mutex_lock(&queue->producer->lock);
+            pthread_cond_signal(&queue->ready);
+            pthread_mutex_unlock(&queue->producer->lock);
+        }
+    }
+}
+
+static void *producer_main(void *arg)
+{
+    deck_producer_t *producer = arg;
+    pthread_mutex_lock(&producer->lock);
+    while (!producer->stop)
+    {
+        if (!producer->wake)
+        {
+            pthread_cond_wait(&producer->work, &producer->lock);
+            continue;
+        }
+        producer->wake = 0;
+
+        // one pass over every table, the rings are filled outside the lock
+        for (int i = 0; i < producer->num_queues && !producer->stop; i++)
+        {
+            deck_queue_t *queue = producer->queues[i];
+            producer->busy = queue;
+            pthread_mutex_unlock(&producer->lock);
+            fill_queue(queue);
+            pthread_mutex_lock(&producer->lock);
+            producer->busy = NULL;
+            pthread_cond_broadcast(&producer->idle);
+        }
+    }
+    pthread_mutex_unlock(&producer->lock);
+    return NULL;
+}
+
+deck_producer_t *deck_producer_start()
+{
+    deck_producer_t *producer = malloc(sizeof(deck_producer_t));
+    if (!producer)
+        return NULL;
+    memset(producer, 0, sizeof(deck_producer_t));
+    pthread_mutex_init(&producer->lock, NULL);
+    pthread_cond_init(&producer->work, NULL);
+    pthread_cond_init(&producer->idle, NULL);
+
+    if (pthread_create(&producer->thread, NULL, producer_main, producer) != 0)
+    {
+        pthread_cond_destroy(&producer->idle);
+        pthread_cond_destroy(&producer->work);
+        pthread_mutex_destroy(&producer->lock);
+        free(producer);
+        return NULL;
+    }
+    return producer;
+}
+
+void deck_producer_stop(deck_producer_t *producer)
+{
+    pthread_mutex_lock(&producer->lock);
+    producer->stop = 1;
+    pthread_cond_signal(&producer->work);
+    pthread_mutex_unlock(&producer->lock);
+    pthread_join(producer->thread, NULL);
+
+    pthread_cond_destroy(&producer->idle);
+    pthread_cond_destroy(&producer->work);
+    pthread_mutex_destroy(&producer->lock);
+    free(producer);
+}
+
+int deck_queue_attach(game_state_t *game, deck_producer_t *producer, int depth)
+{
+    if (game->deck_queue || game->rng.mode == DECK_RNG_LAZY || depth < 1)
+        return -1;
+
+    deck_queue_t *queue;
+    if (posix_memalign((void **) &queue, CACHE_LINE, sizeof(deck_queue_t)) != 0)
+        return -1;
+    memset(queue, 0, sizeof(deck_queue_t));
+
+    queue->depth = depth;
+    queue->low_water = depth / 2;
+    queue->slots = malloc(depth * sizeof(deck_slot_t));
+    if (!queue->slots)
+    {
+        free(queue);
+        return -1;
+    }
+    if (!producer)
+    {
+        producer = deck_producer_start();
+        queue->owns_producer = 1;
+    }
+    if (!producer)
+    {
+        free(queue->slots);
+        free(queue);
+        return -1;
+    }
+
+    // the producer carries on the table's deck and stream, the table only reads them back
+    memcpy(queue->deck, game->deck, sizeof(queue->deck));
+    queue->rng = game->rng;
+    queue->producer = producer;
+    pthread_cond_init(&queue->ready, NULL);
+    atomic_init(&queue->head, 0);
+    atomic_init(&queue->tail, 0);
+    atomic_init(&queue->asked, 0);
+    atomic_init(&queue->waiting, 0);
+
+    pthread_mutex_lock(&producer->lock);
+    int added = producer->num_queues < DECK_PRODUCER_MAX_TABLES;
+    if (added)
+    {
+        producer->queues[producer->num_queues++] = queue;
+        producer->wake = 1;
+        pthread_cond_signal(&producer->work);
+    }
+    pthread_mutex_unlock(&producer->lock);
+
+    if (!added)
+    {
+        pthread_cond_destroy(&queue->ready);
+        free(queue->slots);
+        free(queue);
+        return -1;
+    }
+    game->deck_queue = queue;
+    return 0;
+}
+
+void deck_queue_detach(game_state_t *game)
+{
+    deck_queue_t *queue = game->deck_queue;
+    if (!queue)
+        return;
+
+    deck_producer_t *producer = queue->producer;
+    pthread_mutex_lock(&producer->lock);
+    for (int i = 0; i < producer->num_queues; i++)
+    {
+        if (producer->queues[i] == queue)
+        {
+            producer->queues[i] = producer->queues[--producer->num_queues];
+            break;
+        }
+    }
+    // the table moved into the gap may be skipped by the current pass, run another one
+    producer->wake = 1;
+    pthread_cond_signal(&producer->work);
+    while (producer->busy == queue)
+    {
+        pthread_cond_wait(&producer->idle, &producer->lock);
+    }
+    pthread_mutex_unlock(&producer->lock);
+
+    if (queue->owns_producer)
+        deck_producer_stop(producer);
+
+    // game->rng already holds the state after the last deck popped, the decks shuffled
+    // ahead are simply dropped and will be shuffled again inline
+    pthread_cond_destroy(&queue->ready);
+    free(queue->slots);
+    free(queue);
+    game->deck_queue = NULL;
+}
+
+// sleeps until the producer pushes the deck at head
+static void wait_for_deck(deck_queue_t *queue, uint64_t head)
+{
+    deck_producer_t *producer = queue->producer;
+    pthread_mutex_lock(&producer->lock);
+    producer->wake = 1;
+    pthread_cond_signal(&producer->work);
+    atomic_store(&queue->waiting, 1);
+    while (atomic_load(&queue->tail) == head)
+    {
+        pthread_cond_wait(&queue->ready, &producer->lock);
+    }
+    atomic_store(&queue->waiting, 0);
+    pthread_mutex_unlock(&producer->lock);
+}
+
+void deck_queue_pop(deck_queue_t *queue, card_t deck[DECK_SIZE], deck_rng_t *rng)
+{
+    uint64_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    if (atomic_load_explicit(&queue->tail, memory_order_acquire) == head)
+        wait_for_deck(queue, head);
+
+    const deck_slot_t *slot = &queue->slots[head % queue->depth];
+    memcpy(deck, slot->deck, sizeof(slot->deck));
+    *rng = slot->rng;
+    atomic_store(&queue->head, head + 1);
+
+    // ask for a refill once per drain below the low water mark
+    uint64_t left = atomic_load_explicit(&queue->tail, memory_order_acquire) - (head + 1);
+    if (left <= (uint64_t) queue->low_water && !atomic_load(&queue->asked) && !atomic_exchange(&queue->asked, 1))
+        wake_producer(queue->producer);
+}
@@ -0,0 +1,206 @@
+#include <string.h>
+
+#include "engine.h"
+#include "side_pots.h"
+
+static void add_event(engine_events_t *events, engine_event_type_t type, player_id_t seat, round_stage_t stage, int amount)
+{
+    if (events->count == ENGINE_MAX_EVENTS)
+        return;
+    engine_event_t *event = &events->events[events->count++];
+    event->type = type;
+    event->seat = seat;
+    event->stage = stage;
+    event->amount = amount;
+}
+
+static int is_betting_round(round_stage_t stage)
+{
+    return stage >= ROUND_PREFLOP && stage <= ROUND_RIVER;
+}
+
+// every pot goes to the best hand that can win it (see side_pots.h)
+static void settle(game_state_t *game, engine_events_t *events)
+{
+    game->round_stage = ROUND_SHOWDOWN;
+    side_pots_t pots;
+    build_side_pots(game, &pots);
+    award_side_pots(game, &pots);
+    for (int i = 0; i < game->num_players; i++)
+    {
+        if (pots.payouts[i] == 0)
+            continue;
+        game->player_stacks[i] += pots.payouts[i];
+        add_event(events, ENGINE_EVENT_PAYOUT, i, ROUND_SHOWDOWN, pots.payouts[i]);
+    }
+    add_event(events, ENGINE_EVENT_SHOWDOWN, pots.main_winner, ROUND_SHOWDOWN, game->pot_size);
+}
+
+// the seat that acted last acts first, unless it folded, left or is all in
+static void first_turn(game_state_t *game, engine_events_t *events)
+{
+    if (!(game->active_seats & SEAT_BIT(game->current_player)))
+        game->current_player = next_seat(game->active_seats, game->current_player);
+    add_event(events, ENGINE_EVENT_TURN, game->current_player, game->round_stage, 0);
+}
+
+// deals the community cards of the current stage
+static void begin_street(game_state_t *game, engine_events_t *events)
+{
+    if (game->round_stage == ROUND_FLOP)
+    {
+        deal_community_card(game, 0);
+        deal_community_card(game, 1);
+        deal_community_card(game, 2);
+    }
+    else if (game->round_stage == ROUND_TURN)
+    {
+        deal_community_card(game, 3);
+    }
+    else if (game->round_stage == ROUND_RIVER)
+    {
+        deal_community_card(game, 4);
+    }
+
+    game->street_actions = 0;
+    add_event(events, ENGINE_EVENT_STREET, -1, game->round_stage, 0);
+}
+
+// the next street, or the showdown after the river. once fewer than two seats can still
+// bet the rest of the board is dealt out without any betting
+static void end_street(game_state_t *game, engine_events_t *events)
+{
+    do
+    {
+        game->round_stage++;
+        if (game->round_stage == ROUND_SHOWDOWN)
+        {
+            settle(game, events);
+            return;
+        }
+        begin_street(game, events);
+    } while (seat_count(game->active_seats) < 2);
+
+    first_turn(game, events);
+}
+
+// after a seat acted or left: showdown, next street or next seat
+static void advance(game_state_t *game, engine_events_t *events)
+{
+    int still_in = seat_count(game->active_seats);
+    if (still_in + seat_count(game->allin_seats) <= 1)
+    {
+        settle(game, events);
+        return;
+    }
+
+    // the street is over once the bets are level and there were as many actions as seats betting
+    if (check_betting_end(game) && game->street_actions >= still_in)
+    {
+        end_street(game, events);
+        return;
+    }
+
+    game->current_player = next_seat(game->active_seats, game->current_player);
+    add_event(events, ENGINE_EVENT_TURN, game->current_player, game->round_stage, 0);
+}
+
+int engine_start_hand(game_state_t *game, engine_events_t *events)
+{
+    events->count = 0;
+    if (game->round_stage != ROUND_INIT || seat_count(game->active_seats) < 2)
+        return -1;
+
+    deal_hole_cards(game);
+    add_event(events, ENGINE_EVENT_DEAL, -1, ROUND_PREFLOP, 0);
+
+    game->round_stage = ROUND_PREFLOP;
+    begin_street(game, events);
+    first_turn(game, events);
+    return 0;
+}
+
+int engine_bet(game_state_t *game, player_id_t seat, const engine_action_t *action)
+{
+    switch (action->type)
+    {
+    case CALL:
+    {
+        // a seat short of the bet calls with all it has
+        int to_call = game->highest_bet - game->current_bets[seat];
+        if (to_call > game->player_stacks[seat])
+            to_call = game->player_stacks[seat];
+        game->player_stacks[seat] -= to_call;
+        game->current_bets[seat] += to_call;
+        game->pot_size += to_call;
+        if (game->current_bets[seat] == game->highest_bet)
+            game->matched_seats |= SEAT_BIT(seat);
+        if (game->player_stacks[seat] == 0)
+            set_player_status(game, seat, PLAYER_ALLIN);
+        return 0;
+    }
+    case CHECK:
+        return game->current_bets[seat] == game->highest_bet ? 0 : -1;
+    case RAISE:
+    {
+        // a negative raise would lower the bet to call and hand the raiser chips back
+        int to_call = game->highest_bet - game->current_bets[seat] + action->amount;
+        if (action->amount < 0 || game->player_stacks[seat] < to_call)
+            return -1;
+        game->player_stacks[seat] -= to_call;
+        game->current_bets[seat] += to_call;
+        game->highest_bet += action->amount;
+        game->pot_size += to_call;
+        // no bet is ever above the highest, so a raise leaves the raiser the only seat matched
+        game->matched_seats = action->amount ? SEAT_BIT(seat) : game->matched_seats | SEAT_BIT(seat);
+        if (game->player_stacks[seat] == 0)
+            set_player_status(game, seat, PLAYER_ALLIN);
+        return 0;
+    }
+    case FOLD:
+        set_player_status(game, seat, PLAYER_FOLDED);
+        return 0;
+    default:
+        return -1;
+    }
+}
+
+int engine_apply(game_state_t *game, player_id_t seat, const engine_action_t *action, engine_events_t *events)
+{
+    events->count = 0;
+    if (!is_betting_round(game->round_stage) || seat != game->current_player ||
+        engine_bet(game, seat, action) == -1)
+    {
+        add_event(events, ENGINE_EVENT_REJECTED, seat, game->round_stage, 0);
+        if (is_betting_round(game->round_stage))
+            add_event(events, ENGINE_EVENT_TURN, game->current_player, game->round_stage, 0);
+        return -1;
+    }
+
+    game->street_actions++;
+    add_event(events, ENGINE_EVENT_ACCEPTED, seat, game->round_stage, action->amount);
+    advance(game, events);
+    return 0;
+}
+
+void engine_leave(game_state_t *game, player_id_t seat, engine_events_t *events)
+{
+    events->count = 0;
+    if (seat < 0 || seat >= game->num_players || game->player_status[seat] == PLAYER_LEFT)
+        return;
+
+    int was_to_act = is_betting_round(game->round_stage) && seat == game->current_player &&
+                     game->player_status[seat] == PLAYER_ACTIVE;
+    set_player_status(game, seat, PLAYER_LEFT);
+    add_event(events, ENGINE_EVENT_LEFT, seat, game->round_stage, 0);
+
+    if (was_to_act)
+    {
+        advance(game, events);
+    }
+    else if (is_betting_round(game->round_stage) &&
+             seat_count(game->active_seats | game->allin_seats) <= 1)
+    {
+        settle(game, events);
+    }
+}
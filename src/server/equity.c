@@ -0,0 +1,598 @@
+#include <math.h>
+#include <time.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "equity.h"
+#include "hand_eval.h"
+#include "rng.h"
+#include "platform.h"
+#include "parallel.h"
+
+#define DEADLINE_CHECK_MASK 1023 // look at the clock every 1024 runouts
+
+// everything the workers need to know about a query, computed once
+typedef struct {
+    const equity_query_t *query;
+    hand_eval_state_t known_board;          // the known community cards
+    card_t remaining[DECK_SIZE];            // cards that can still come on the board
+    int num_remaining;
+    int num_missing;                        // community cards still to be dealt
+} equity_spot_t;
+
+// per seat running totals, one copy per worker
+typedef struct {
+    long runouts;
+    long wins[MAX_PLAYERS];
+    long ties[MAX_PLAYERS];
+    double share[MAX_PLAYERS];
+    double share_sq[MAX_PLAYERS];
+} equity_tally_t;
+
+typedef struct {
+    const equity_spot_t *spot;
+    long samples;                           // 0 for no limit
+    const struct timespec *deadline;        // NULL for no limit
+    uint64_t seed;
+    equity_tally_t tally;
+} __attribute__((aligned(CACHE_LINE))) equity_worker_t;
+
+static int prepare_spot(const equity_query_t *query, equity_spot_t *spot)
+{
+    if (query->num_players < 2 || query->num_players > MAX_PLAYERS)
+        return -1;
+    // a street is preflop, the flop, the turn or the river, never one or two board cards
+    if (query->num_board < 0 || query->num_board > MAX_COMMUNITY_CARDS || query->num_board == 1 || query->num_board == 2)
+        return -1;
+
+    // every known card must be a real card and appear only once
+    card_set_t known = query->dead;
+    int num_known = card_set_count(known);
+    for (int p = 0; p < query->num_players; p++)
+    {
+        for (int i = 0; i < HAND_SIZE; i++)
+        {
+            card_t card = query->hole_cards[p][i];
+            if (card < 0 || card >= DECK_SIZE)
+                return -1;
+            known = card_set_add(known, card);
+            num_known++;
+        }
+    }
+    for (int i = 0; i < query->num_board; i++)
+    {
+        card_t card = query->board[i];
+        if (card < 0 || card >= DECK_SIZE)
+            return -1;
+        known = card_set_add(known, card);
+        num_known++;
+    }
+    if (card_set_count(known) != num_known)
+        return -1;
+
+    hand_eval_init();
+
+    spot->query = query;
+    hand_eval_state_init(&spot->known_board);
+    for (int i = 0; i < query->num_board; i++)
+    {
+        hand_eval_state_add(&spot->known_board, query->board[i]);
+    }
+
+    spot->num_remaining = card_set_to_cards(card_set_minus(CARD_SET_DECK, known), spot->remaining);
+    spot->num_missing = MAX_COMMUNITY_CARDS - query->num_board;
+    if (spot->num_remaining < spot->num_missing)
+        return -1;
+
+    return 0;
+}
+
+// scores one complete board and credits the winner(s)
+static void tally_board(const equity_spot_t *spot, const hand_eval_state_t *board, equity_tally_t *tally)
+{
+    const equity_query_t *query = spot->query;
+    int values[MAX_PLAYERS];
+    int best = -1, num_best = 0;
+
+    for (int p = 0; p < query->num_players; p++)
+    {
+        hand_eval_state_t hand = *board;
+        hand_eval_state_add(&hand, query->hole_cards[p][0]);
+        hand_eval_state_add(&hand, query->hole_cards[p][1]);
+        values[p] = hand_eval_state_value(&hand);
+
+        if (values[p] > best)
+        {
+            best = values[p];
+            num_best = 1;
+        }
+        else if (values[p] == best)
+        {
+            num_best++;
+        }
+    }
+
+    double share = 1.0 / num_best;
+    for (int p = 0; p < query->num_players; p++)
+    {
+        if (values[p] == best)
+        {
+            if (num_best == 1)
+                tally->wins[p]++;
+            else
+                tally->ties[p]++;
+            tally->share[p] += share;
+            tally->share_sq[p] += share * share;
+        }
+    }
+    tally->runouts++;
+}
+
+static void merge_tally(equity_tally_t *into, const equity_tally_t *from)
+{
+    into->runouts += from->runouts;
+    for (int p = 0; p < MAX_PLAYERS; p++)
+    {
+        into->wins[p] += from->wins[p];
+        into->ties[p] += from->ties[p];
+        into->share[p] += from->share[p];
+        into->share_sq[p] += from->share_sq[p];
+    }
+}
+
+static void finish_result(const equity_query_t *query, const equity_tally_t *tally, equity_result_t *out)
+{
+    memset(out, 0, sizeof(equity_result_t));
+    out->samples = tally->runouts;
+    if (tally->runouts == 0)
+        return;
+
+    double n = (double) tally->runouts;
+    for (int p = 0; p < query->num_players; p++)
+    {
+        double mean = tally->share[p] / n;
+        double variance = tally->share_sq[p] / n - mean * mean;
+        if (variance < 0)
+            variance = 0;
+
+        out->win[p] = tally->wins[p] / n;
+        out->tie[p] = tally->ties[p] / n;
+        out->equity[p] = mean;
+        out->equity_ci95[p] = 1.96 * sqrt(variance / n);
+    }
+}
+
+typedef struct {
+    const equity_spot_t *spot;
+    long first;                             // rank of the first runout to enumerate
+    long count;                             // how many runouts to enumerate
+    equity_tally_t tally;
+} __attribute__((aligned(CACHE_LINE))) enumeration_worker_t;
+
+static void *enumeration_worker(void *arg)
+{
+    enumeration_worker_t *worker = arg;
+    const equity_spot_t *spot = worker->spot;
+    int combo[MAX_COMMUNITY_CARDS];
+
+    unrank_combination(worker->first, spot->num_remaining, spot->num_missing, combo);
+    for (long done = 0; done < worker->count; done++)
+    {
+        hand_eval_state_t board = spot->known_board;
+        for (int k = 0; k < spot->num_missing; k++)
+        {
+            hand_eval_state_add(&board, spot->remaining[combo[k]]);
+        }
+        tally_board(spot, &board, &worker->tally);
+
+        next_combination(spot->num_remaining, spot->num_missing, combo);
+    }
+
+    return NULL;
+}
+
+static void *monte_carlo_worker(void *arg)
+{
+    equity_worker_t *worker = arg;
+    const equity_spot_t *spot = worker->spot;
+
+    rng_t rng;
+    rng_seed(&rng, worker->seed);
+
+    card_t deck[DECK_SIZE];
+    memcpy(deck, spot->remaining, spot->num_remaining * sizeof(card_t));
+
+    for (long done = 0; worker->samples == 0 || done < worker->samples; done++)
+    {
+        if (worker->deadline && (done & DEADLINE_CHECK_MASK) == 0 && past_deadline(worker->deadline))
+            break;
+
+        // partial Fisher-Yates: only draw the cards the board is missing
+        hand_eval_state_t board = spot->known_board;
+        for (int k = 0; k < spot->num_missing; k++)
+        {
+            int j = k + rng_below(&rng, spot->num_remaining - k);
+            card_t temp = deck[k];
+            deck[k] = deck[j];
+            deck[j] = temp;
+            hand_eval_state_add(&board, deck[k]);
+        }
+
+        tally_board(spot, &board, &worker->tally);
+    }
+
+    return NULL;
+}
+
+int equity_monte_carlo(const equity_query_t *query, const equity_config_t *config, equity_result_t *out)
+{
+    if (!query || !config || !out)
+        return -1;
+    if (config->samples <= 0 && config->time_budget_ms <= 0)
+        return -1;
+
+    equity_spot_t spot;
+    if (prepare_spot(query, &spot) == -1)
+        return -1;
+
+    long samples = config->samples;
+    if (spot.num_missing == 0)
+        samples = 1; // nothing left to deal, a single runout is exact
+
+    int num_threads = thread_count(config->num_threads, samples);
+
+    struct timespec deadline;
+    int has_deadline = config->time_budget_ms > 0 && spot.num_missing > 0;
+    if (has_deadline)
+    {
+        deadline_after(&deadline, config->time_budget_ms);
+    }
+
+    equity_worker_t workers[num_threads];
+    memset(workers, 0, sizeof(workers));
+
+    for (int t = 0; t < num_threads; t++)
+    {
+        workers[t].spot = &spot;
+        workers[t].samples = samples > 0 ? samples / num_threads + (t < samples % num_threads) : 0;
+        workers[t].deadline = has_deadline ? &deadline : NULL;
+        workers[t].seed = config->seed ^ ((uint64_t) t * 0x9e3779b97f4a7c15ULL);
+    }
+
+    run_workers(monte_carlo_worker, workers, sizeof(equity_worker_t), num_threads);
+
+    equity_tally_t total;
+    memset(&total, 0, sizeof(total));
+    for (int t = 0; t < num_threads; t++)
+    {
+        merge_tally(&total, &workers[t].tally);
+    }
+
+    finish_result(query, &total, out);
+    return 0;
+}
+
+int equity_exhaustive(const equity_query_t *query, int num_threads, equity_result_t *out)
+{
+    if (!query || !out)
+        return -1;
+
+    equity_spot_t spot;
+    if (prepare_spot(query, &spot) == -1)
+        return -1;
+
+    long total = choose(spot.num_remaining, spot.num_missing);
+    num_threads = thread_count(num_threads, total);
+
+    enumeration_worker_t workers[num_threads];
+    memset(workers, 0, sizeof(workers));
+
+    // split the runouts into contiguous ranges of (almost) equal size
+    for (int t = 0; t < num_threads; t++)
+    {
+        workers[t].spot = &spot;
+        split_work(total, num_threads, t, &workers[t].first, &workers[t].count);
+    }
+
+    run_workers(enumeration_worker, workers, sizeof(enumeration_worker_t), num_threads);
+
+    equity_tally_t tally;
+    memset(&tally, 0, sizeof(tally));
+    for (int t = 0; t < num_threads; t++)
+    {
+        merge_tally(&tally, &workers[t].tally);
+    }
+
+    finish_result(query, &tally, out);
+    // every runout was counted, there is no sampling error
+    memset(out->equity_ci95, 0, sizeof(out->equity_ci95));
+    return 0;
+}
+
+int equity_query_from_game(game_state_t *game, equity_query_t *query, player_id_t seats[MAX_PLAYERS])
+{
+    memset(query, 0, sizeof(equity_query_t));
+
+    for (int i = 0; i < game->num_players; i++)
+    {
+        if (game->player_status[i] == PLAYER_ACTIVE || game->player_status[i] == PLAYER_ALLIN)
+        {
+            memcpy(query->hole_cards[query->num_players], game->player_hands[i], sizeof(game->player_hands[i]));
+            seats[query->num_players++] = i;
+        }
+    }
+
+    for (int i = 0; i < game->community_dealt; i++)
+    {
+        query->board[query->num_board++] = game->community_cards[i];
+    }
+
+    return query->num_players;
+}
+
+/**
+ * range vs range
+ *
+ * for every runout both ranges are valued and sorted, then the hero combos are swept
+ * in order of strength while the villain weight below (and level with) the current
+ * value is accumulated, both in total and per card. the villain weight a hero combo
+ * actually faces is the total minus the weight of the combos holding either of its
+ * cards, plus the combo with both cards (it was subtracted twice), so blocked pairs
+ * are skipped without ever looking at them one by one.
+ */
+
+typedef struct {
+    int combo;
+    int value;
+    double weight;
+} range_entry_t;
+
+typedef struct {
+    double total;
+    double by_card[DECK_SIZE];
+} blocker_sum_t;
+
+typedef struct {
+    const range_t *hero;
+    const range_t *villain;
+    hand_eval_state_t known_board;
+    card_set_t known;                       // board and dead cards
+    card_t remaining[DECK_SIZE];
+    int num_remaining;
+    int num_missing;
+    card_t combo_lo[RANGE_COMBOS];
+    card_t combo_hi[RANGE_COMBOS];
+} range_spot_t;
+
+typedef struct {
+    const range_spot_t *spot;
+    long first;                             // rank of the first runout to sweep
+    long count;                             // how many runouts to sweep
+    long combo_first;                       // the hero combos this worker sweeps on each runout
+    long combo_count;
+    double won[RANGE_COMBOS];               // weighted share of the pot per hero combo
+    double faced[RANGE_COMBOS];             // weighted number of matchups per hero combo
+    int failed;                             // the worker could not allocate its sort buffers
+} __attribute__((aligned(CACHE_LINE))) range_worker_t;
+
+static int compare_entries(const void *a, const void *b)
+{
+    const range_entry_t *x = a, *y = b;
+    return (x->value > y->value) - (x->value < y->value);
+}
+
+static void blocker_add(blocker_sum_t *sum, const range_spot_t *spot, const range_entry_t *entry)
+{
+    sum->total += entry->weight;
+    sum->by_card[spot->combo_lo[entry->combo]] += entry->weight;
+    sum->by_card[spot->combo_hi[entry->combo]] += entry->weight;
+}
+
+// weight of the combos in sum that share no card with combo, given the weight of combo itself in sum
+static double blocker_unblocked(const blocker_sum_t *sum, const range_spot_t *spot, int combo, double self)
+{
+    return sum->total - sum->by_card[spot->combo_lo[combo]] - sum->by_card[spot->combo_hi[combo]] + self;
+}
+
+// values every live combo of a range in [first, first + count) on a complete board, returns how many there are
+static int value_range(const range_spot_t *spot, const range_t *range, long first, long count,
+                       const hand_eval_state_t *board, card_set_t board_set, range_entry_t *out)
+{
+    int n = 0;
+    for (long c = first; c < first + count; c++)
+    {
+        if (range->weight[c] <= 0 || (range_combo_mask(c) & board_set))
+            continue;
+
+        hand_eval_state_t hand = *board;
+        hand_eval_state_add(&hand, spot->combo_lo[c]);
+        hand_eval_state_add(&hand, spot->combo_hi[c]);
+        out[n].combo = c;
+        out[n].value = hand_eval_state_value(&hand);
+        out[n].weight = range->weight[c];
+        n++;
+    }
+    qsort(out, n, sizeof(range_entry_t), compare_entries);
+    return n;
+}
+
+static void sweep_runout(range_worker_t *worker, const hand_eval_state_t *board, card_set_t board_set,
+                         range_entry_t *hero, range_entry_t *villain)
+{
+    const range_spot_t *spot = worker->spot;
+    int num_hero = value_range(spot, spot->hero, worker->combo_first, worker->combo_count, board, board_set, hero);
+    int num_villain = value_range(spot, spot->villain, 0, RANGE_COMBOS, board, board_set, villain);
+
+    blocker_sum_t all, below, level;
+    memset(&all, 0, sizeof(all));
+    memset(&below, 0, sizeof(below));
+    memset(&level, 0, sizeof(level));
+    for (int v = 0; v < num_villain; v++)
+    {
+        blocker_add(&all, spot, &villain[v]);
+    }
+
+    int v = 0;
+    int level_value = -1;
+    for (int h = 0; h < num_hero; h++)
+    {
+        int value = hero[h].value;
+        if (value != level_value)
+        {
+            // the previous level is now strictly below, collect the new one
+            while (v < num_villain && villain[v].value < value)
+            {
+                blocker_add(&below, spot, &villain[v++]);
+            }
+            memset(&level, 0, sizeof(level));
+            for (int l = v; l < num_villain && villain[l].value == value; l++)
+            {
+                blocker_add(&level, spot, &villain[l]);
+            }
+            level_value = value;
+        }
+
+        // the villain combo with exactly the hero's cards has the same value, so it sits in level
+        int combo = hero[h].combo;
+        double self = spot->villain->weight[combo];
+        double faced = blocker_unblocked(&all, spot, combo, self);
+        double beaten = blocker_unblocked(&below, spot, combo, 0);
+        double tied = blocker_unblocked(&level, spot, combo, self);
+
+        worker->won[combo] += hero[h].weight * (beaten + tied / 2);
+        worker->faced[combo] += hero[h].weight * faced;
+    }
+}
+
+static void *range_worker(void *arg)
+{
+    range_worker_t *worker = arg;
+    const range_spot_t *spot = worker->spot;
+    range_entry_t *hero = malloc(2 * RANGE_COMBOS * sizeof(range_entry_t));
+    if (!hero)
+    {
+        worker->failed = 1;
+        return NULL;
+    }
+    range_entry_t *villain = hero + RANGE_COMBOS;
+    int combo[MAX_COMMUNITY_CARDS];
+
+    unrank_combination(worker->first, spot->num_remaining, spot->num_missing, combo);
+    for (long done = 0; done < worker->count; done++)
+    {
+        hand_eval_state_t board = spot->known_board;
+        card_set_t board_set = spot->known;
+        for (int k = 0; k < spot->num_missing; k++)
+        {
+            hand_eval_state_add(&board, spot->remaining[combo[k]]);
+            board_set = card_set_add(board_set, spot->remaining[combo[k]]);
+        }
+        sweep_runout(worker, &board, board_set, hero, villain);
+
+        next_combination(spot->num_remaining, spot->num_missing, combo);
+    }
+
+    free(hero);
+    return NULL;
+}
+
+int equity_range_vs_range(const range_t *hero, const range_t *villain, const card_t *board, int num_board,
+                          card_set_t dead, int num_threads, range_equity_result_t *out)
+{
+    if (!hero || !villain || !out || num_board < 3 || num_board > MAX_COMMUNITY_CARDS)
+        return -1;
+
+    hand_eval_init();
+
+    range_spot_t *spot = malloc(sizeof(range_spot_t));
+    if (!spot)
+        return -1;
+    spot->hero = hero;
+    spot->villain = villain;
+    spot->known = dead;
+    hand_eval_state_init(&spot->known_board);
+    for (int i = 0; i < num_board; i++)
+    {
+        if (board[i] < 0 || board[i] >= DECK_SIZE || card_set_contains(spot->known, board[i]))
+        {
+            free(spot);
+            return -1;
+        }
+        spot->known = card_set_add(spot->known, board[i]);
+        hand_eval_state_add(&spot->known_board, board[i]);
+    }
+    spot->num_remaining = card_set_to_cards(card_set_minus(CARD_SET_DECK, spot->known), spot->remaining);
+    spot->num_missing = MAX_COMMUNITY_CARDS - num_board;
+    for (int c = 0; c < RANGE_COMBOS; c++)
+    {
+        range_combo_cards(c, &spot->combo_lo[c], &spot->combo_hi[c]);
+    }
+
+    // every runout covers every combo pair. the runouts are split over the threads, or
+    // when there are fewer runouts than threads (a turn or river board) each runout is
+    // split again by hero combos, every thread of a runout still values the whole villain range
+    long total = choose(spot->num_remaining, spot->num_missing);
+    num_threads = thread_count(num_threads, total * RANGE_COMBOS);
+    int slices = num_threads > total ? num_threads / (int) total : 1;
+    if (slices > 1)
+        num_threads = (int) total * slices;
+
+    range_worker_t *workers = aligned_alloc(CACHE_LINE, num_threads * sizeof(range_worker_t));
+    if (!workers)
+    {
+        free(spot);
+        return -1;
+    }
+    memset(workers, 0, num_threads * sizeof(range_worker_t));
+
+    for (int t = 0; t < num_threads; t++)
+    {
+        workers[t].spot = spot;
+        if (slices > 1)
+        {
+            workers[t].first = t / slices;
+            workers[t].count = 1;
+            split_work(RANGE_COMBOS, slices, t % slices, &workers[t].combo_first, &workers[t].combo_count);
+        }
+        else
+        {
+            split_work(total, num_threads, t, &workers[t].first, &workers[t].count);
+            workers[t].combo_count = RANGE_COMBOS;
+        }
+    }
+
+    run_workers(range_worker, workers, sizeof(range_worker_t), num_threads);
+
+    memset(out, 0, sizeof(range_equity_result_t));
+    double won = 0, faced = 0;
+    int failed = 0;
+    for (int t = 0; t < num_threads; t++)
+    {
+        failed |= workers[t].failed;
+    }
+    if (failed)
+    {
+        free(workers);
+        free(spot);
+        return -1;
+    }
+    for (int c = 0; c < RANGE_COMBOS; c++)
+    {
+        double combo_won = 0, combo_faced = 0;
+        for (int t = 0; t < num_threads; t++)
+        {
+            combo_won += workers[t].won[c];
+            combo_faced += workers[t].faced[c];
+        }
+        if (combo_faced > 0)
+            out->combo_equity[c] = combo_won / combo_faced;
+        won += combo_won;
+        faced += combo_faced;
+    }
+    out->equity = faced > 0 ? won / faced : 0;
+    out->matchups = faced;
+
+    free(workers);
+    free(spot);
+    return faced > 0 ? 0 : -1;
+}
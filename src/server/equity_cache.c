@@ -0,0 +1,373 @@
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "equity_cache.h"
+#include "platform.h"
+
+#define NUM_SUITE_ORDERS 24
+
+// a spot in suit canonical form, compared and hashed as raw bytes so it must be zeroed first
+typedef struct {
+    uint64_t dead;                                  // card set, the lanes are renamed with the suits
+    int64_t samples;                                // 0 for exact results, -1 for time budgeted ones
+    uint8_t num_players;
+    uint8_t num_board;
+    uint8_t cards[MAX_PLAYERS * HAND_SIZE + MAX_COMMUNITY_CARDS];
+} cache_key_t;
+
+typedef struct {
+    cache_key_t key;
+    uint64_t hash;
+    int next;                                       // next entry of the same bucket, -1 at the end
+    int referenced;                                 // hit since the clock hand last passed
+    equity_result_t result;
+} cache_entry_t;
+
+typedef struct {
+    pthread_mutex_t lock;
+    cache_entry_t *entries;
+    int *buckets;                                   // first entry of every bucket, -1 if empty
+    int num_buckets;                                // a power of two
+    int capacity;
+    int size;
+    int hand;                                       // the clock hand, the next eviction candidate
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+} __attribute__((aligned(CACHE_LINE))) cache_shard_t;
+
+struct equity_cache {
+    cache_shard_t shards[EQUITY_CACHE_SHARDS];
+};
+
+static uint8_t suite_orders[NUM_SUITE_ORDERS][NUM_SUITES];
+static pthread_once_t orders_once = PTHREAD_ONCE_INIT;
+
+static void build_suite_orders()
+{
+    int n = 0;
+    for (int a = 0; a < NUM_SUITES; a++)
+    {
+        for (int b = 0; b < NUM_SUITES; b++)
+        {
+            for (int c = 0; c < NUM_SUITES; c++)
+            {
+                int d = 6 - a - b - c;
+                if (a == b || a == c || b == c)
+                    continue;
+                suite_orders[n][0] = a;
+                suite_orders[n][1] = b;
+                suite_orders[n][2] = c;
+                suite_orders[n][3] = d;
+                n++;
+            }
+        }
+    }
+}
+
+static uint8_t rename_card(card_t card, const uint8_t *order)
+{
+    return (card & ~((1 << SUITE_BITS) - 1)) | order[SUITE(card)];
+}
+
+static void sort_bytes(uint8_t *bytes, int n)
+{
+    for (int i = 1; i < n; i++)
+    {
+        for (int j = i; j > 0 && bytes[j - 1] < bytes[j]; j--)
+        {
+            uint8_t t = bytes[j];
+            bytes[j] = bytes[j - 1];
+            bytes[j - 1] = t;
+        }
+    }
+}
+
+// the query with its suits renamed, with the cards of every hand and of the board sorted
+static void rename_query(const equity_query_t *query, int64_t samples, const uint8_t *order, cache_key_t *key)
+{
+    memset(key, 0, sizeof(cache_key_t));
+    key->samples = samples;
+    key->num_players = query->num_players;
+    key->num_board = query->num_board;
+
+    for (int s = 0; s < NUM_SUITES; s++)
+    {
+        key->dead |= (uint64_t) card_set_suite(query->dead, s) << (order[s] * CARD_SET_LANE_BITS);
+    }
+
+    uint8_t *cards = key->cards;
+    for (int p = 0; p < query->num_players; p++)
+    {
+        for (int i = 0; i < HAND_SIZE; i++)
+        {
+            cards[i] = rename_card(query->hole_cards[p][i], order);
+        }
+        sort_bytes(cards, HAND_SIZE);
+        cards += HAND_SIZE;
+    }
+    for (int i = 0; i < query->num_board; i++)
+    {
+        cards[i] = rename_card(query->board[i], order);
+    }
+    sort_bytes(cards, query->num_board);
+}
+
+// the smallest renaming of the query, so every suit isomorphic query gets the same key
+static int make_key(const equity_query_t *query, int64_t samples, cache_key_t *key)
+{
+    if (query->num_players < 2 || query->num_players > MAX_PLAYERS)
+        return -1;
+    if (query->num_board < 0 || query->num_board > MAX_COMMUNITY_CARDS)
+        return -1;
+    for (int p = 0; p < query->num_players; p++)
+    {
+        for (int i = 0; i < HAND_SIZE; i++)
+        {
+            if (query->hole_cards[p][i] < 0 || query->hole_cards[p][i] >= DECK_SIZE)
+                return -1;
+        }
+    }
+    for (int i = 0; i < query->num_board; i++)
+    {
+        if (query->board[i] < 0 || query->board[i] >= DECK_SIZE)
+            return -1;
+    }
+
+    pthread_once(&orders_once, build_suite_orders);
+
+    rename_query(query, samples, suite_orders[0], key);
+    for (int o = 1; o < NUM_SUITE_ORDERS; o++)
+    {
+        cache_key_t candidate;
+        rename_query(query, samples, suite_orders[o], &candidate);
+        if (memcmp(&candidate, key, sizeof(cache_key_t)) < 0)
+            *key = candidate;
+    }
+    return 0;
+}
+
+// FNV-1a with a final mix, the top bits pick the shard and the low bits the bucket
+static uint64_t hash_key(const cache_key_t *key)
+{
+    const uint8_t *bytes = (const uint8_t *) key;
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < sizeof(cache_key_t); i++)
+    {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+    }
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+static cache_shard_t *shard_of(equity_cache_t *cache, uint64_t hash)
+{
+    return &cache->shards[hash >> 60 & (EQUITY_CACHE_SHARDS - 1)];
+}
+
+// the entry holding key, -1 if there is none. the shard must be locked
+static int find_entry(const cache_shard_t *shard, const cache_key_t *key, uint64_t hash)
+{
+    for (int i = shard->buckets[hash & (shard->num_buckets - 1)]; i != -1; i = shard->entries[i].next)
+    {
+        if (shard->entries[i].hash == hash && memcmp(&shard->entries[i].key, key, sizeof(cache_key_t)) == 0)
+            return i;
+    }
+    return -1;
+}
+
+static void unlink_entry(cache_shard_t *shard, int entry)
+{
+    int *link = &shard->buckets[shard->entries[entry].hash & (shard->num_buckets - 1)];
+    while (*link != entry)
+    {
+        link = &shard->entries[*link].next;
+    }
+    *link = shard->entries[entry].next;
+}
+
+// sweeps the clock hand over the entries, giving every referenced entry a second chance
+static int evict_entry(cache_shard_t *shard)
+{
+    while (shard->entries[shard->hand].referenced)
+    {
+        shard->entries[shard->hand].referenced = 0;
+        shard->hand = (shard->hand + 1) % shard->capacity;
+    }
+    int victim = shard->hand;
+    shard->hand = (shard->hand + 1) % shard->capacity;
+
+    unlink_entry(shard, victim);
+    shard->evictions++;
+    return victim;
+}
+
+static int cache_lookup(equity_cache_t *cache, const cache_key_t *key, uint64_t hash, equity_result_t *out)
+{
+    cache_shard_t *shard = shard_of(cache, hash);
+    pthread_mutex_lock(&shard->lock);
+
+    int entry = find_entry(shard, key, hash);
+    if (entry != -1)
+    {
+        shard->entries[entry].referenced = 1;
+        *out = shard->entries[entry].result;
+        shard->hits++;
+    }
+    else
+    {
+        shard->misses++;
+    }
+
+    pthread_mutex_unlock(&shard->lock);
+    return entry != -1;
+}
+
+static void cache_insert(equity_cache_t *cache, const cache_key_t *key, uint64_t hash, const equity_result_t *result)
+{
+    cache_shard_t *shard = shard_of(cache, hash);
+    pthread_mutex_lock(&shard->lock);
+
+    // another thread may have computed the same spot in the meantime
+    int entry = find_entry(shard, key, hash);
+    if (entry == -1)
+    {
+        entry = shard->size < shard->capacity ? shard->size++ : evict_entry(shard);
+
+        // new entries start unreferenced, a spot asked about only once is the first to go
+        shard->entries[entry].key = *key;
+        shard->entries[entry].hash = hash;
+        shard->entries[entry].referenced = 0;
+
+        int *bucket = &shard->buckets[hash & (shard->num_buckets - 1)];
+        shard->entries[entry].next = *bucket;
+        *bucket = entry;
+    }
+    shard->entries[entry].result = *result;
+
+    pthread_mutex_unlock(&shard->lock);
+}
+
+equity_cache_t *equity_cache_create(size_t capacity)
+{
+    equity_cache_t *cache;
+    if (posix_memalign((void **) &cache, CACHE_LINE, sizeof(equity_cache_t)) != 0)
+        return NULL;
+    memset(cache, 0, sizeof(equity_cache_t));
+
+    int per_shard = (int) ((capacity + EQUITY_CACHE_SHARDS - 1) / EQUITY_CACHE_SHARDS);
+    if (per_shard < 1)
+        per_shard = 1;
+    int num_buckets = 1;
+    while (num_buckets < per_shard)
+    {
+        num_buckets <<= 1;
+    }
+
+    for (int s = 0; s < EQUITY_CACHE_SHARDS; s++)
+    {
+        pthread_mutex_init(&cache->shards[s].lock, NULL);
+    }
+    for (int s = 0; s < EQUITY_CACHE_SHARDS; s++)
+    {
+        cache_shard_t *shard = &cache->shards[s];
+        shard->capacity = per_shard;
+        shard->num_buckets = num_buckets;
+        shard->entries = malloc(per_shard * sizeof(cache_entry_t));
+        shard->buckets = malloc(num_buckets * sizeof(int));
+        if (!shard->entries || !shard->buckets)
+        {
+            equity_cache_destroy(cache);
+            return NULL;
+        }
+        memset(shard->buckets, -1, num_buckets * sizeof(int));
+    }
+    return cache;
+}
+
+void equity_cache_destroy(equity_cache_t *cache)
+{
+    if (!cache)
+        return;
+    for (int s = 0; s < EQUITY_CACHE_SHARDS; s++)
+    {
+        pthread_mutex_destroy(&cache->shards[s].lock);
+        free(cache->shards[s].entries);
+        free(cache->shards[s].buckets);
+    }
+    free(cache);
+}
+
+int equity_cache_monte_carlo(equity_cache_t *cache, const equity_query_t *query, const equity_config_t *config,
+                             equity_result_t *out)
+{
+    if (!cache || !query || !config || !out)
+        return -1;
+
+    // a run under a time budget may stop short of config->samples, it is keyed as time budgeted
+    cache_key_t key;
+    long samples = config->time_budget_ms > 0 || config->samples <= 0 ? -1 : config->samples;
+    if (make_key(query, samples, &key) == -1)
+        return -1;
+    uint64_t hash = hash_key(&key);
+
+    if (cache_lookup(cache, &key, hash, out))
+        return 0;
+    if (equity_monte_carlo(query, config, out) == -1)
+        return -1;
+    cache_insert(cache, &key, hash, out);
+    return 0;
+}
+
+int equity_cache_exhaustive(equity_cache_t *cache, const equity_query_t *query, int num_threads, equity_result_t *out)
+{
+    if (!cache || !query || !out)
+        return -1;
+
+    cache_key_t key;
+    if (make_key(query, 0, &key) == -1)
+        return -1;
+    uint64_t hash = hash_key(&key);
+
+    if (cache_lookup(cache, &key, hash, out))
+        return 0;
+    if (equity_exhaustive(query, num_threads, out) == -1)
+        return -1;
+    cache_insert(cache, &key, hash, out);
+    return 0;
+}
+
+void equity_cache_stats(equity_cache_t *cache, equity_cache_stats_t *out)
+{
+    memset(out, 0, sizeof(equity_cache_stats_t));
+    for (int s = 0; s < EQUITY_CACHE_SHARDS; s++)
+    {
+        cache_shard_t *shard = &cache->shards[s];
+        pthread_mutex_lock(&shard->lock);
+        out->hits += shard->hits;
+        out->misses += shard->misses;
+        out->evictions += shard->evictions;
+        out->entries += shard->size;
+        out->capacity += shard->capacity;
+        pthread_mutex_unlock(&shard->lock);
+    }
+}
+
+void equity_cache_clear(equity_cache_t *cache)
+{
+    for (int s = 0; s < EQUITY_CACHE_SHARDS; s++)
+    {
+        cache_shard_t *shard = &cache->shards[s];
+        pthread_mutex_lock(&shard->lock);
+        memset(shard->buckets, -1, shard->num_buckets * sizeof(int));
+        shard->size = 0;
+        shard->hand = 0;
+        shard->hits = 0;
+        shard->misses = 0;
+        shard->evictions = 0;
+        pthread_mutex_unlock(&shard->lock);
+    }
+}
@@ -0,0 +1,709 @@
+/**
+ * checks an evaluator against a reference over every 7 card hand
+ *
+ * usage: server.eval_verify [CANDIDATE] [THREADS]
+ *
+ * the reference scores a hand straight from its rank and suit counts, category by
+ * category, without any of the tables of hand_eval.c. the candidate
+ * (cards, fixed, set, state or batch, default cards) passes if it puts the same category on
+ * every hand and orders all 133,784,560 hands exactly like the reference: hands the
+ * reference calls equal get the same value, better hands a higher one.
+ *
+ * the hands are handed out to THREADS workers (default: every online core) by their
+ * two lowest cards, one pair at a time.
+ *
+ * the strength candidate checks hand_strength() instead, on random spots: the strength
+ * on a river and the EHS² of a turn against the reference over every opponent holding,
+ * and AA before the flop against its known value. the draws candidate checks the outs
+ * analyze_draws() finds on random flops and turns against trying every unseen card.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "hand_eval.h"
+#include "card_set.h"
+#include "utility.h"
+#include "hand_strength.h"
+#include "rng.h"
+#include "game_logic.h"
+#include "parallel.h"
+#include "platform.h"
+
+#define HAND_CARDS 7
+#define CHUNK_HANDS 1024
+#define NUM_CATEGORIES (HAND_STRAIGHT_FLUSH + 1)
+#define VALUE_SLOTS (NUM_CATEGORIES << HAND_CATEGORY_SHIFT)
+#define MAX_REPORTED 10
+
+// the two lowest cards of a hand, every pair a < b is one work item
+#define NUM_WORK_ITEMS (DECK_SIZE * DECK_SIZE)
+
+typedef void (*eval_fn_t)(const card_t *hands, int num_hands, int *values);
+
+typedef struct {
+    const char *name;
+    eval_fn_t eval;
+    long (*spots)(rng_t *rng);              // for the candidates checked on random spots, returns the mismatches
+} candidate_t;
+
+typedef struct {
+    long hands;
+    long reference_categories[NUM_CATEGORIES];
+    long candidate_categories[NUM_CATEGORIES];
+    long mismatches;
+} __attribute__((aligned(CACHE_LINE))) verify_tally_t;
+
+static const long expected_categories[NUM_CATEGORIES] = {
+    [HAND_HIGH_CARD] = 23294460,
+    [HAND_ONE_PAIR] = 58627800,
+    [HAND_TWO_PAIR] = 31433400,
+    [HAND_TRIPS] = 6461620,
+    [HAND_STRAIGHT] = 6180020,
+    [HAND_FLUSH] = 4047644,
+    [HAND_FULL_HOUSE] = 3473184,
+    [HAND_QUADS] = 224848,
+    [HAND_STRAIGHT_FLUSH] = 41584,
+};
+
+static const char *category_names[NUM_CATEGORIES] = {
+    [HAND_HIGH_CARD] = "high card",
+    [HAND_ONE_PAIR] = "one pair",
+    [HAND_TWO_PAIR] = "two pair",
+    [HAND_TRIPS] = "trips",
+    [HAND_STRAIGHT] = "straight",
+    [HAND_FLUSH] = "flush",
+    [HAND_FULL_HOUSE] = "full house",
+    [HAND_QUADS] = "quads",
+    [HAND_STRAIGHT_FLUSH] = "straight flush",
+};
+
+// the candidate value of every reference value seen so far, -1 if none yet
+static atomic_int *candidate_of;
+
+static const candidate_t *candidate;
+static atomic_int next_item = 0;
+static atomic_int reported = 0;
+static pthread_mutex_t report_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// ------------------------------- reference -------------------------------- //
+
+// the high card of the best straight among the present ranks, -1 if there is none
+static int reference_straight(const int present[NUM_RANKS])
+{
+    for (int high = NUM_RANKS - 1; high >= 3; high--)
+    {
+        int run = 0;
+        for (int r = high; r > high - 5; r--)
+        {
+            // below the two comes the ace again
+            run += present[r >= 0 ? r : NUM_RANKS - 1] > 0;
+        }
+        if (run == 5)
+            return high;
+    }
+    return -1;
+}
+
+// the highest ranks present that are not excluded, highest first
+static int reference_kickers(const int present[NUM_RANKS], int exclude1, int exclude2, int count, int *ranks)
+{
+    int n = 0;
+    for (int r = NUM_RANKS - 1; r >= 0 && n < count; r--)
+    {
+        if (present[r] && r != exclude1 && r != exclude2)
+            ranks[n++] = r;
+    }
+    return n;
+}
+
+static int reference_value(int category, const int *ranks, int n)
+{
+    int value = category;
+    for (int i = 0; i < 5; i++)
+    {
+        value = (value << 4) | (i < n ? ranks[i] : 0);
+    }
+    return value;
+}
+
+// the value of up to 7 cards, fewer than 5 simply have fewer kickers
+static int reference_eval(const card_t *cards, int num_cards)
+{
+    int counts[NUM_RANKS] = { 0 };
+    int suites[NUM_SUITES][NUM_RANKS] = { { 0 } };
+    int suite_counts[NUM_SUITES] = { 0 };
+    for (int i = 0; i < num_cards; i++)
+    {
+        counts[RANK(cards[i])]++;
+        suites[SUITE(cards[i])][RANK(cards[i])] = 1;
+        suite_counts[SUITE(cards[i])]++;
+    }
+
+    int flush = -1;
+    for (int s = 0; s < NUM_SUITES; s++)
+    {
+        if (suite_counts[s] >= 5)
+            flush = s;
+    }
+
+    int ranks[5];
+    if (flush >= 0)
+    {
+        ranks[0] = reference_straight(suites[flush]);
+        if (ranks[0] >= 0)
+            return reference_value(HAND_STRAIGHT_FLUSH, ranks, 1);
+    }
+
+    // the ranks held 4, 3 and 2 times, highest first
+    int quads = -1, trips[2] = { -1, -1 }, pairs[3] = { -1, -1, -1 };
+    int num_trips = 0, num_pairs = 0;
+    for (int r = NUM_RANKS - 1; r >= 0; r--)
+    {
+        if (counts[r] == 4 && quads < 0)
+            quads = r;
+        else if (counts[r] == 3)
+            trips[num_trips++] = r;
+        else if (counts[r] == 2)
+            pairs[num_pairs++] = r;
+    }
+
+    if (quads >= 0)
+    {
+        ranks[0] = quads;
+        int n = 1 + reference_kickers(counts, quads, -1, 1, ranks + 1);
+        return reference_value(HAND_QUADS, ranks, n);
+    }
+
+    if (num_trips > 0 && (num_trips > 1 || num_pairs > 0))
+    {
+        ranks[0] = trips[0];
+        ranks[1] = num_trips > 1 && trips[1] > pairs[0] ? trips[1] : pairs[0];
+        return reference_value(HAND_FULL_HOUSE, ranks, 2);
+    }
+
+    if (flush >= 0)
+    {
+        reference_kickers(suites[flush], -1, -1, 5, ranks);
+        return reference_value(HAND_FLUSH, ranks, 5);
+    }
+
+    ranks[0] = reference_straight(counts);
+    if (ranks[0] >= 0)
+        return reference_value(HAND_STRAIGHT, ranks, 1);
+
+    if (num_trips > 0)
+    {
+        ranks[0] = trips[0];
+        int n = 1 + reference_kickers(counts, trips[0], -1, 2, ranks + 1);
+        return reference_value(HAND_TRIPS, ranks, n);
+    }
+
+    if (num_pairs >= 2)
+    {
+        ranks[0] = pairs[0];
+        ranks[1] = pairs[1];
+        int n = 2 + reference_kickers(counts, pairs[0], pairs[1], 1, ranks + 2);
+        return reference_value(HAND_TWO_PAIR, ranks, n);
+    }
+
+    if (num_pairs == 1)
+    {
+        ranks[0] = pairs[0];
+        int n = 1 + reference_kickers(counts, pairs[0], -1, 3, ranks + 1);
+        return reference_value(HAND_ONE_PAIR, ranks, n);
+    }
+
+    int n = reference_kickers(counts, -1, -1, 5, ranks);
+    return reference_value(HAND_HIGH_CARD, ranks, n);
+}
+
+// ------------------------------- candidates ------------------------------- //
+
+static void eval_cards(const card_t *hands, int num_hands, int *values)
+{
+    for (int i = 0; i < num_hands; i++)
+    {
+        values[i] = hand_eval_cards(hands + i * HAND_CARDS, HAND_CARDS);
+    }
+}
+
+static void eval_fixed(const card_t *hands, int num_hands, int *values)
+{
+    for (int i = 0; i < num_hands; i++)
+    {
+        values[i] = hand_eval_7(hands + i * HAND_CARDS);
+    }
+}
+
+static void eval_set(const card_t *hands, int num_hands, int *values)
+{
+    for (int i = 0; i < num_hands; i++)
+    {
+        values[i] = hand_eval_set(card_set_from_cards(hands + i * HAND_CARDS, HAND_CARDS));
+    }
+}
+
+static void eval_state(const card_t *hands, int num_hands, int *values)
+{
+    for (int i = 0; i < num_hands; i++)
+    {
+        hand_eval_state_t state;
+        hand_eval_state_init(&state);
+        for (int j = 0; j < HAND_CARDS; j++)
+        {
+            hand_eval_state_add(&state, hands[i * HAND_CARDS + j]);
+        }
+        values[i] = hand_eval_state_value(&state);
+    }
+}
+
+static void eval_batch(const card_t *hands, int num_hands, int *values)
+{
+    hand_eval_batch(hands, num_hands, values);
+}
+
+// --------------------------------- spots ---------------------------------- //
+
+#define SPOT_CHECKS 200
+#define SPOT_SEED 0x73706f7473ULL
+#define SPOT_EPSILON 1e-9
+#define MAX_SPOT_CARDS 7
+#define AA_SAMPLES 200000
+#define AA_STRENGTH 0.852                   // AA against one random hand before the flop, ties count half
+#define AA_TOLERANCE 0.004                  // about 4 standard errors at AA_SAMPLES runouts
+#define DRAW_CHECKS 200000                  // outs are cheap to check, half flops and half turns
+
+// n distinct random cards, the first steps of a Fisher-Yates shuffle
+static void deal_spot(rng_t *rng, card_t *cards, int n)
+{
+    card_t deck[DECK_SIZE];
+    for (int i = 0; i < DECK_SIZE; i++)
+    {
+        deck[i] = i;
+    }
+    for (int i = 0; i < n; i++)
+    {
+        int j = i + rng_below(rng, DECK_SIZE - i);
+        card_t temp = deck[i];
+        deck[i] = deck[j];
+        deck[j] = temp;
+        cards[i] = deck[i];
+    }
+}
+
+static void report_spot(const char *what, const card_t *cards, int num_cards, double reference, double value)
+{
+    if (reported++ >= MAX_REPORTED)
+        return;
+    printf("%s:", what);
+    for (int i = 0; i < num_cards; i++)
+    {
+        printf(" %s", card_name(cards[i]));
+    }
+    printf(" (reference %.9f, candidate %.9f)\n", reference, value);
+}
+
+// the share of the holdings left that a hand beats on a full board, ties count half
+static double reference_river_strength(const card_t hole[2], const card_t board[5])
+{
+    card_t hero[HAND_CARDS], villain[HAND_CARDS];
+    memcpy(hero, hole, 2 * sizeof(card_t));
+    memcpy(hero + 2, board, 5 * sizeof(card_t));
+    memcpy(villain + 2, board, 5 * sizeof(card_t));
+    int hero_value = reference_eval(hero, HAND_CARDS);
+    card_set_t known = card_set_from_cards(hero, HAND_CARDS);
+
+    long ahead = 0, tied = 0, seen = 0;
+    for (card_t a = 0; a < DECK_SIZE; a++)
+    {
+        if (card_set_contains(known, a))
+            continue;
+        for (card_t b = a + 1; b < DECK_SIZE; b++)
+        {
+            if (card_set_contains(known, b))
+                continue;
+            villain[0] = a;
+            villain[1] = b;
+            int value = reference_eval(villain, HAND_CARDS);
+            ahead += hero_value > value;
+            tied += hero_value == value;
+            seen++;
+        }
+    }
+    return (ahead + tied / 2.0) / seen;
+}
+
+static long check_strength(rng_t *rng)
+{
+    long mismatches = 0;
+    hand_strength_config_t exact = { .num_threads = 1 };
+    hand_strength_t result;
+    card_t cards[MAX_SPOT_CARDS];
+
+    // rivers: the strength now, against every holding
+    for (int s = 0; s < SPOT_CHECKS; s++)
+    {
+        deal_spot(rng, cards, 7);
+        hand_strength(cards, cards + 2, 5, &exact, &result);
+        double reference = reference_river_strength(cards, cards + 2);
+        if (fabs(result.hs - reference) > SPOT_EPSILON)
+        {
+            report_spot("river hs", cards, 7, reference, result.hs);
+            mismatches++;
+        }
+    }
+
+    // turns: EHS² is the mean squared river strength over every river card
+    for (int s = 0; s < SPOT_CHECKS; s++)
+    {
+        deal_spot(rng, cards, 6);
+        hand_strength(cards, cards + 2, 4, &exact, &result);
+        card_set_t known = card_set_from_cards(cards, 6);
+        double sum = 0;
+        int rivers = 0;
+        for (cards[6] = 0; cards[6] < DECK_SIZE; cards[6]++)
+        {
+            if (card_set_contains(known, cards[6]))
+                continue;
+            double hs = reference_river_strength(cards, cards + 2);
+            sum += hs * hs;
+            rivers++;
+        }
+        if (fabs(result.ehs2 - sum / rivers) > SPOT_EPSILON)
+        {
+            report_spot("turn ehs2", cards, 6, sum / rivers, result.ehs2);
+            mismatches++;
+        }
+    }
+
+    // a known value, sampled since going over every preflop runout takes minutes
+    hand_strength_config_t sampled = { .runouts = AA_SAMPLES, .seed = SPOT_SEED };
+    card_t aces[2] = { ACE OF SPADE, ACE OF HEART };
+    hand_strength(aces, NULL, 0, &sampled, &result);
+    if (fabs(result.hs - AA_STRENGTH) > AA_TOLERANCE)
+    {
+        report_spot("preflop hs", aces, 2, AA_STRENGTH, result.hs);
+        mismatches++;
+    }
+    printf("AA preflop: hs %.4f over %ld runouts (known %.3f)\n", result.hs, result.runouts, AA_STRENGTH);
+    printf("strength: %d rivers and %d turns\n", SPOT_CHECKS, SPOT_CHECKS);
+    return mismatches;
+}
+
+// the unseen cards that put a hand (the hole cards, then the board) in a better category,
+// and in a better one than the board with that card plays on its own
+static card_set_t reference_outs(const card_t *cards, int num_cards)
+{
+    card_t hand[HAND_CARDS], board[HAND_CARDS];
+    int num_board = num_cards - 2;
+    memcpy(hand, cards, num_cards * sizeof(card_t));
+    memcpy(board, cards + 2, num_board * sizeof(card_t));
+    int category = HAND_CATEGORY(reference_eval(hand, num_cards));
+    card_set_t known = card_set_from_cards(cards, num_cards);
+
+    card_set_t outs = CARD_SET_EMPTY;
+    for (card_t card = 0; card < DECK_SIZE; card++)
+    {
+        if (card_set_contains(known, card))
+            continue;
+        hand[num_cards] = card;
+        board[num_board] = card;
+        int improved = HAND_CATEGORY(reference_eval(hand, num_cards + 1));
+        if (improved > category && improved > HAND_CATEGORY(reference_eval(board, num_board + 1)))
+            outs |= card_set_of(card);
+    }
+    return outs;
+}
+
+// analyze_draws() only values one card per rank away from flush suites, the reference
+// goes over all 47 (flop) or 46 (turn) unseen cards
+static long check_draws(rng_t *rng)
+{
+    long mismatches = 0;
+    card_t cards[MAX_SPOT_CARDS];
+    draw_info_t info;
+
+    for (int s = 0; s < DRAW_CHECKS; s++)
+    {
+        int num_cards = s % 2 ? 6 : 5;
+        deal_spot(rng, cards, num_cards);
+        analyze_draws(card_set_from_cards(cards, 2), card_set_from_cards(cards + 2, num_cards - 2), &info);
+        card_set_t reference = reference_outs(cards, num_cards);
+        if (info.out_cards != reference || info.outs != card_set_count(reference))
+        {
+            report_spot(num_cards == 5 ? "flop outs" : "turn outs", cards, num_cards,
+                        card_set_count(reference), info.outs);
+            mismatches++;
+        }
+    }
+    printf("draws: %d flops and turns\n", DRAW_CHECKS);
+    return mismatches;
+}
+
+static const candidate_t candidates[] = {
+    { "cards", eval_cards },
+    { "fixed", eval_fixed },
+    { "set", eval_set },
+    { "state", eval_state },
+    { "batch", eval_batch },
+    { "strength", NULL, check_strength },
+    { "draws", NULL, check_draws },
+};
+
+#define NUM_CANDIDATES ((int) (sizeof(candidates) / sizeof(candidates[0])))
+
+// -------------------------------- workers --------------------------------- //
+
+static void report_hand(const char *what, const card_t *cards, int reference, int value)
+{
+    if (atomic_fetch_add(&reported, 1) >= MAX_REPORTED)
+        return;
+
+    pthread_mutex_lock(&report_lock);
+    printf("%s:", what);
+    for (int i = 0; i < HAND_CARDS; i++)
+    {
+        printf(" %s", card_name(cards[i]));
+    }
+    printf(" (reference %#x, candidate %#x)\n", reference, value);
+    pthread_mutex_unlock(&report_lock);
+}
+
+static void check_chunk(const card_t *hands, int num_hands, verify_tally_t *tally)
+{
+    int values[CHUNK_HANDS];
+    candidate->eval(hands, num_hands, values);
+
+    for (int i = 0; i < num_hands; i++)
+    {
+        const card_t *cards = hands + i * HAND_CARDS;
+        int reference = reference_eval(cards, HAND_CARDS);
+        int category = HAND_CATEGORY(values[i]);
+
+        tally->reference_categories[HAND_CATEGORY(reference)]++;
+        if (category > 0 && category < NUM_CATEGORIES)
+            tally->candidate_categories[category]++;
+
+        if (category != HAND_CATEGORY(reference))
+        {
+            tally->mismatches++;
+            report_hand("category", cards, reference, values[i]);
+            continue;
+        }
+
+        // the first hand with this reference value fixes the candidate value for all the others
+        int expected = -1;
+        if (!atomic_compare_exchange_strong(&candidate_of[reference], &expected, values[i]) && expected != values[i])
+        {
+            tally->mismatches++;
+            report_hand("value", cards, reference, values[i]);
+        }
+    }
+    tally->hands += num_hands;
+}
+
+// steps to the next 5 card combination, rest[4] goes past the deck after the last one
+static void next_five(int rest[5])
+{
+    int i = 4;
+    while (i > 0 && rest[i] == DECK_SIZE - 5 + i)
+    {
+        i--;
+    }
+    rest[i]++;
+    for (int j = i + 1; j < 5; j++)
+    {
+        rest[j] = rest[j - 1] + 1;
+    }
+}
+
+static void *worker(void *arg)
+{
+    verify_tally_t *tally = arg;
+    card_t *hands = malloc(CHUNK_HANDS * HAND_CARDS * sizeof(card_t));
+    int item;
+
+    while ((item = atomic_fetch_add(&next_item, 1)) < NUM_WORK_ITEMS)
+    {
+        int a = item / DECK_SIZE, b = item % DECK_SIZE;
+        if (b <= a)
+            continue;
+
+        // every 5 card combination of the cards above b, in lexicographic order
+        int rest[5] = { b + 1, b + 2, b + 3, b + 4, b + 5 };
+        int num_hands = 0;
+        while (rest[4] < DECK_SIZE)
+        {
+            card_t *cards = hands + num_hands * HAND_CARDS;
+            cards[0] = a;
+            cards[1] = b;
+            for (int i = 0; i < 5; i++)
+            {
+                cards[2 + i] = rest[i];
+            }
+            if (++num_hands == CHUNK_HANDS)
+            {
+                check_chunk(hands, num_hands, tally);
+                num_hands = 0;
+            }
+            next_five(rest);
+        }
+        if (num_hands > 0)
+            check_chunk(hands, num_hands, tally);
+    }
+
+    free(hands);
+    return NULL;
+}
+
+// walks the reference values upwards, the candidate values have to go up with them
+static long check_order(long *num_values)
+{
+    long mismatches = 0;
+    int last_reference = -1, last_value = -1;
+    *num_values = 0;
+
+    for (int reference = 0; reference < VALUE_SLOTS; reference++)
+    {
+        int value = atomic_load(&candidate_of[reference]);
+        if (value == -1)
+            continue;
+
+        if (last_reference >= 0 && value <= last_value)
+        {
+            mismatches++;
+            if (atomic_fetch_add(&reported, 1) < MAX_REPORTED)
+                printf("order: reference %#x < %#x but candidate %#x >= %#x\n", last_reference, reference, last_value, value);
+        }
+        last_reference = reference;
+        last_value = value;
+        (*num_values)++;
+    }
+    return mismatches;
+}
+
+// runs a candidate checked on random spots, on the calling thread (hand_strength() has its own)
+static int verify_spots()
+{
+    hand_eval_init();
+    rng_t rng;
+    rng_seed(&rng, SPOT_SEED);
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    long mismatches = candidate->spots(&rng);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    printf("\ncandidate %s: %.1f s\n", candidate->name, seconds);
+    printf("%s: %ld mismatches\n", mismatches ? "FAILED" : "PASSED", mismatches);
+    return mismatches ? 1 : 0;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 3)
+    {
+        fprintf(stderr, "usage: %s [CANDIDATE] [THREADS]\n", argv[0]);
+        return 1;
+    }
+
+    const char *name = argc >= 2 ? argv[1] : candidates[0].name;
+    for (int i = 0; i < NUM_CANDIDATES; i++)
+    {
+        if (strcmp(name, candidates[i].name) == 0)
+            candidate = &candidates[i];
+    }
+    if (!candidate)
+    {
+        fprintf(stderr, "unknown candidate %s, expected one of:", name);
+        for (int i = 0; i < NUM_CANDIDATES; i++)
+        {
+            fprintf(stderr, " %s", candidates[i].name);
+        }
+        fprintf(stderr, "\n");
+        return 1;
+    }
+
+    if (candidate->spots)
+        return verify_spots();
+
+    int num_threads = argc >= 3 ? atoi(argv[2]) : default_threads();
+    if (num_threads <= 0)
+    {
+        fprintf(stderr, "threads must be positive.\n");
+        return 1;
+    }
+    num_threads = thread_count(num_threads, 0);
+
+    candidate_of = malloc(VALUE_SLOTS * sizeof(atomic_int));
+    verify_tally_t *tallies = aligned_alloc(CACHE_LINE, num_threads * sizeof(verify_tally_t));
+    if (!candidate_of || !tallies)
+    {
+        perror("malloc");
+        return 1;
+    }
+    for (int i = 0; i < VALUE_SLOTS; i++)
+    {
+        atomic_init(&candidate_of[i], -1);
+    }
+    memset(tallies, 0, num_threads * sizeof(verify_tally_t));
+
+    hand_eval_init();
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    pthread_t threads[num_threads];
+    for (int t = 0; t < num_threads; t++)
+    {
+        pthread_create(&threads[t], NULL, worker, &tallies[t]);
+    }
+    for (int t = 0; t < num_threads; t++)
+    {
+        pthread_join(threads[t], NULL);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    verify_tally_t total;
+    memset(&total, 0, sizeof(total));
+    for (int t = 0; t < num_threads; t++)
+    {
+        total.hands += tallies[t].hands;
+        total.mismatches += tallies[t].mismatches;
+        for (int c = 0; c < NUM_CATEGORIES; c++)
+        {
+            total.reference_categories[c] += tallies[t].reference_categories[c];
+            total.candidate_categories[c] += tallies[t].candidate_categories[c];
+        }
+    }
+
+    long num_values;
+    total.mismatches += check_order(&num_values);
+
+    printf("\n%-16s %12s %12s %12s\n", "category", "expected", "reference", "candidate");
+    for (int c = HAND_STRAIGHT_FLUSH; c >= HAND_HIGH_CARD; c--)
+    {
+        if (total.reference_categories[c] != expected_categories[c] ||
+            total.candidate_categories[c] != expected_categories[c])
+            total.mismatches++;
+        printf("%-16s %12ld %12ld %12ld\n", category_names[c], expected_categories[c],
+               total.reference_categories[c], total.candidate_categories[c]);
+    }
+
+    printf("\ncandidate %s: %ld hands, %ld distinct values, %.1f s with %d threads, %.1f M hands/s\n",
+           candidate->name, total.hands, num_values, seconds, num_threads, total.hands / seconds / 1e6);
+    printf("%s: %ld mismatches\n", total.mismatches ? "FAILED" : "PASSED", total.mismatches);
+
+    free(tallies);
+    free(candidate_of);
+    return total.mismatches ? 1 : 0;
+}
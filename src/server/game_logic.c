@@ -8,6 +8,9 @@
 #include "poker_client.h"
 #include "client_action_handler.h"
 #include "game_logic.h"
+#include "hand_eval.h"
+#include "deck_queue.h"
+#include "engine.h"
 #include "logs.h"
 
 // Feel free to add your own code. I stripped out most of our solution functions but I left some "breadcrumbs" for anyone lost
@@ -68,19 +71,116 @@ void shuffle_deck(card_t deck[DECK_SIZE])
     }
 }
 
+void deck_rng_seed(deck_rng_t *rng, deck_rng_mode_t mode, uint64_t seed)
+{
+    rng->mode = mode;
+    if (mode == DECK_RNG_LEGACY)
+        rng_legacy_seed(&rng->legacy, (unsigned int) seed);
+    else if (mode == DECK_RNG_COUNTER)
+        deck_rng_seed_counter(rng, seed, 0, 0);
+    else
+        rng_seed(&rng->xoshiro, seed);
+}
+
+void deck_rng_seed_counter(deck_rng_t *rng, uint64_t seed, uint32_t table, uint64_t first_hand)
+{
+    rng->mode = DECK_RNG_COUNTER;
+    rng->counter.seed = seed;
+    rng->counter.table = table;
+    rng->counter.hand = first_hand;
+}
+
+/**
+ * in counter mode a deck does not depend on the decks before it: it is the ordered deck
+ * shuffled by the Philox stream of (seed, table, hand). any hand can be dealt again on
+ * any thread without replaying the ones before it.
+ */
+void deal_deck(uint64_t seed, uint32_t table, uint64_t hand, card_t deck[DECK_SIZE])
+{
+    rng_counter_t rng;
+    rng_counter_init(&rng, seed, (uint32_t) hand, (uint32_t) (hand >> 32), table);
+
+    for (int i = 0; i < DECK_SIZE; i++)
+    {
+        deck[i] = i;
+    }
+    for (int i = DECK_SIZE - 1; i > 0; i--)
+    {
+        int j = rng_counter_below(&rng, i + 1);
+        card_t temp = deck[i];
+        deck[i] = deck[j];
+        deck[j] = temp;
+    }
+}
+
+void deck_rng_shuffle(deck_rng_t *rng, card_t deck[DECK_SIZE])
+{
+    if (rng->mode == DECK_RNG_COUNTER)
+    {
+        deal_deck(rng->counter.seed, rng->counter.table, rng->counter.hand++, deck);
+        return;
+    }
+    if (rng->mode == DECK_RNG_LEGACY)
+    {
+        // the same swaps as shuffle_deck, biased as they are, so the deck order does not change
+        for (int i = 0; i < DECK_SIZE; i++)
+        {
+            int j = rng_legacy_next(&rng->legacy) % DECK_SIZE;
+            card_t temp = deck[i];
+            deck[i] = deck[j];
+            deck[j] = temp;
+        }
+        return;
+    }
+
+    // also the lazy mode, if a whole deck is wanted at once
+    for (int i = DECK_SIZE - 1; i > 0; i--)
+    {
+        int j = rng_below(&rng->xoshiro, i + 1);
+        card_t temp = deck[i];
+        deck[i] = deck[j];
+        deck[j] = temp;
+    }
+}
+
+/**
+ * in the lazy mode the deck is not shuffled between hands, every draw swaps a random
+ * card of the undealt rest into place instead. a hand then only pays for the cards it
+ * deals, and the deck stays a permutation so the next hand can start from it as is.
+ */
+card_t draw_card(game_state_t *game)
+{
+    int i = game->next_card++;
+    if (game->rng.mode == DECK_RNG_LAZY)
+    {
+        int j = i + rng_below(&game->rng.xoshiro, DECK_SIZE - i);
+        card_t temp = game->deck[i];
+        game->deck[i] = game->deck[j];
+        game->deck[j] = temp;
+    }
+    return game->deck[i];
+}
+
 // You dont need to use this if you dont want, but we did.
 void init_game_state(game_state_t *game, int starting_stack, int random_seed)
 {
     memset(game, 0, sizeof(game_state_t));
-    init_deck(game->deck, random_seed);
+    // the table owns its generator, seeded like init_deck seeds rand() so the decks stay the same
+    deck_rng_seed(&game->rng, DECK_RNG_LEGACY, (unsigned int) random_seed);
+    for (int i = 0; i < DECK_SIZE; i++)
+    {
+        game->deck[i] = i;                         // rank major, the order of init_deck
+    }
+    hand_eval_init();
     for (int i = 0; i < MAX_PLAYERS; i++)
     {
         game->player_stacks[i] = starting_stack;
-        game->player_status[i] = PLAYER_ACTIVE;
+        set_player_status(game, i, PLAYER_ACTIVE);
     }
     game->num_players = MAX_PLAYERS;
     game->next_card = 0;
     game->highest_bet = 0;
+    game->matched_seats = SEATS_BELOW(MAX_PLAYERS);
     game->pot_size = 0;
 
     game->dealer_player = 0;
@@ -91,22 +191,27 @@ void init_game_state(game_state_t *game, int starting_stack, int random_seed)
 
 void reset_game_state(game_state_t *game)
 {
-    shuffle_deck(game->deck);
+    if (game->deck_queue)
+        deck_queue_pop(game->deck_queue, game->deck, &game->rng);
+    else if (game->rng.mode != DECK_RNG_LAZY)
+        deck_rng_shuffle(&game->rng, game->deck);
     // Call this function between hands.
     // You should add your own code, I just wanted to make sure the deck got shuffled.
     game->next_card = 0;
     memset(game->current_bets, 0, sizeof(game->current_bets));
     game->highest_bet = 0;
+    game->matched_seats = SEATS_BELOW(game->num_players);
     game->pot_size = 0;
+    game->community_dealt = 0;
     game->round_stage = ROUND_INIT;
 
-    // Reset folded players to active for next hand
+    // Reset folded and all in players to active for next hand, busted seats sit out folded
+    seat_mask_t funded = funded_seats(game);
     for (int i = 0; i < game->num_players; i++)
     {
-        if (game->player_status[i] == PLAYER_FOLDED)
-        {
-            game->player_status[i] = PLAYER_ACTIVE;
-        }
+        if (game->player_status[i] == PLAYER_LEFT)
+            continue;
+        set_player_status(game, i, funded & SEAT_BIT(i) ? PLAYER_ACTIVE : PLAYER_FOLDED);
     }
 }
 
@@ -121,7 +226,7 @@ void server_join(game_state_t *game)
         if (bytes <= 0 || in.packet_type != JOIN)
         {
             // Mark player as left on error or invalid packet
-            game->player_status[i] = PLAYER_LEFT;
+            set_player_status(game, i, PLAYER_LEFT);
             log_info("Player %d failed to join or sent invalid packet. Marked as LEFT.", i);
 
             // Close the socket for the player who failed to join
@@ -160,7 +265,7 @@ int server_ready(game_state_t *game)
                 }
                 else if (in.packet_type == LEAVE)
                 {
-                    game->player_status[i] = PLAYER_LEFT;
+                    set_player_status(game, i, PLAYER_LEFT);
                     ready[i] = 1;
                     ready_count++;
                     log_info("Player %d has LEFT.", i);
@@ -174,7 +279,7 @@ int server_ready(game_state_t *game)
             else if (bytes <= 0)
             {
                 // Handle disconnection as a LEAVE
-                game->player_status[i] = PLAYER_LEFT;
+                set_player_status(game, i, PLAYER_LEFT);
                 ready[i] = 1;
                 ready_count++;
                 log_info("Player %d disconnected. Marked as LEFT.", i);
@@ -184,24 +289,12 @@ int server_ready(game_state_t *game)
         }
         }
 
-    // Count active players
-    int active_players = 0;
-    for (int i = 0; i < game->num_players; i++)
-    {
-        if (game->player_status[i] == PLAYER_ACTIVE)
-        {
-            active_players++;
-        }
-    }
-
-    return active_players;
+    return seat_count(game->active_seats);
 }
 
 // This was our dealing function with some of the code removed (I left the dealing so we have the same logic)
-void server_deal(game_state_t *game)
+void deal_hole_cards(game_state_t *game)
 {
-    int card_index = game->next_card;
-
     // Deal 2 cards to each active player
     for (int i = 0; i < game->num_players; i++)
     {
@@ -209,110 +302,236 @@ void server_deal(game_state_t *game)
         {
             for (int j = 0; j < HAND_SIZE; j++)
             {
-                game->player_hands[i][j] = game->deck[card_index++];
-                printf("Dealt %s to player %d\n",
-                       card_name(game->player_hands[i][j]), i);
+                game->player_hands[i][j] = draw_card(game);
             }
         }
     }
 
-    // Store remaining cards for community cards
+    // Store remaining cards for community cards. deal_community_card draws the board again
+    // later, so a lazy deck (which pays a shuffle step per card) only clears it. the shuffled
+    // modes keep skipping these cards so their deals match the logged games
     for (int i = 0; i < MAX_COMMUNITY_CARDS; i++)
     {
-        game->community_cards[i] = game->deck[card_index++];
+        game->community_cards[i] = game->rng.mode == DECK_RNG_LAZY ? NOCARD : draw_card(game);
     }
 
-    game->next_card = card_index;
+    // Start tracking each hand from the hole cards, the board is added as it is dealt
+    for (int i = 0; i < game->num_players; i++)
+    {
+        hand_eval_state_init(&game->hands_so_far[i]);
+        if (game->player_status[i] == PLAYER_ACTIVE)
+        {
+            for (int j = 0; j < HAND_SIZE; j++)
+            {
+                hand_eval_state_add(&game->hands_so_far[i], game->player_hands[i][j]);
+            }
+        }
+        game->hand_values[i] = hand_eval_state_value(&game->hands_so_far[i]);
+    }
+    game->community_dealt = 0;
 }
 
-int server_bet(game_state_t *game)
+// Draws the next card of the deck into a community card slot and adds it to every player's hand
+void deal_community_card(game_state_t *game, int slot)
 {
-    // This was our function to determine if everyone has called or folded
+    card_t card = draw_card(game);
+    game->community_cards[slot] = card;
 
-    while (!check_betting_end(game))
+    for (int i = 0; i < game->num_players; i++)
     {
-        // Send INFO packet to current player
-        server_packet_t info_pkt;
-        build_info_packet(game, game->current_player, &info_pkt);
-        send(game->sockets[game->current_player], &info_pkt, sizeof(info_pkt), 0);
+        hand_eval_state_add(&game->hands_so_far[i], card);
+        game->hand_values[i] = hand_eval_state_value(&game->hands_so_far[i]);
+    }
+    game->community_dealt++;
+}
 
-        // Get action from current player
-        client_packet_t in;
-        int rv = recv(game->sockets[game->current_player], &in, sizeof(in), 0);
-        if (rv <= 0)
+// Sends what the players have to know about the engine events and logs them
+static void server_dispatch(game_state_t *game, const engine_events_t *events)
+{
+    for (int e = 0; e < events->count; e++)
+    {
+        const engine_event_t *event = &events->events[e];
+        server_packet_t pkt;
+        switch (event->type)
         {
-            // Instead of erroring out, simulate a CHECK action
-            // log_info("[INFO] [Client ~> Server] Sending packet: type=CHECK");
-            in.packet_type = CHECK;
+        case ENGINE_EVENT_DEAL:
+            for (int i = 0; i < game->num_players; i++)
+            {
+                if (game->player_status[i] == PLAYER_ACTIVE)
+                {
+                    for (int j = 0; j < HAND_SIZE; j++)
+                    {
+                        printf("Dealt %s to player %d\n", card_name(game->player_hands[i][j]), i);
+                    }
+                }
+            }
+            break;
+
+        case ENGINE_EVENT_STREET:
+            server_community(game);
+            for (int i = 0; i < game->num_players; i++)
+            {
+                if ((game->active_seats | game->allin_seats) & SEAT_BIT(i))
+                {
+                    build_info_packet(game, i, &pkt);
+                    send(game->sockets[i], &pkt, sizeof(pkt), 0);
+                    log_info("Sent INFO packet to player %d.", i);
+                }
+            }
+            break;
+
+        case ENGINE_EVENT_TURN:
+            // a turn passed on by an action, not a new street or a refused action
+            if (e > 0 && events->events[e - 1].type == ENGINE_EVENT_ACCEPTED)
+                log_info("Next player turn: %d", event->seat);
+            build_info_packet(game, event->seat, &pkt);
+            send(game->sockets[event->seat], &pkt, sizeof(pkt), 0);
+            break;
+
+        case ENGINE_EVENT_ACCEPTED:
+        case ENGINE_EVENT_REJECTED:
+            memset(&pkt, 0, sizeof(pkt));
+            pkt.packet_type = event->type == ENGINE_EVENT_ACCEPTED ? ACK : NACK;
+            send(game->sockets[event->seat], &pkt, sizeof(pkt), 0);
+            if (event->type == ENGINE_EVENT_REJECTED)
+                break;
+
+            log_info("Game state after action:");
+            log_info("Pot size: %d", game->pot_size);
+            log_info("Highest bet: %d", game->highest_bet);
+            for (int i = 0; i < game->num_players; i++)
+            {
+                log_info("Player %d: stack=%d, bet=%d, status=%d",
+                         i, game->player_stacks[i], game->current_bets[i], game->player_status[i]);
+            }
+            break;
+
+        case ENGINE_EVENT_LEFT:
+            log_info("Player %d disconnected. Marked as LEFT.", event->seat);
+            if (game->sockets[event->seat] >= 0)
+                close(game->sockets[event->seat]);
+            game->sockets[event->seat] = -1;
+            break;
+
+        case ENGINE_EVENT_PAYOUT:
+            // a pot that went to one seat whole is reported by server_end
+            if (event->amount != game->pot_size)
+                printf("Player %d collects %d\n", event->seat, event->amount);
+            break;
+
+        case ENGINE_EVENT_SHOWDOWN:
+            server_end(game, event->seat);
+            break;
         }
+    }
+}
+
+// Starts a hand for the ready players
+int server_deal(game_state_t *game)
+{
+    engine_events_t events;
+    if (engine_start_hand(game, &events) == -1)
+        return -1;
+    server_dispatch(game, &events);
+    return 0;
+}
+
+// Plays one betting round over the sockets, returns once the stage moved on
+int server_bet(game_state_t *game)
+{
+    round_stage_t stage = game->round_stage;
+    while (game->round_stage == stage)
+    {
+        player_id_t pid = game->current_player;
+        engine_events_t events;
 
-        server_packet_t resp;
-        if (handle_client_action(game, game->current_player, &in, &resp) == 0)
+        client_packet_t in;
+        ssize_t bytes = recv(game->sockets[pid], &in, sizeof(in), 0);
+        if (bytes <= 0)
         {
-            send(game->sockets[game->current_player], &resp, sizeof(resp), 0);
+            engine_leave(game, pid, &events);
         }
         else
         {
-            resp.packet_type = NACK;
-            send(game->sockets[game->current_player], &resp, sizeof(resp), 0);
-            continue;
+            engine_action_t action = { .type = in.packet_type, .amount = in.params[0] };
+            engine_apply(game, pid, &action, &events);
         }
+        server_dispatch(game, &events);
+    }
+    return 0;
+}
 
-        // Move to next active player
-        int next = (game->current_player + 1) % game->num_players;
-        while (game->player_status[next] != PLAYER_ACTIVE)
-        {
-            next = (next + 1) % game->num_players;
-            if (next == game->current_player)
-                break;
-        }
-        game->current_player = next;
+void set_player_status(game_state_t *game, player_id_t seat, player_status_t status)
+{
+    seat_mask_t bit = SEAT_BIT(seat);
+    game->player_status[seat] = status;
+    game->active_seats &= ~bit;
+    game->allin_seats &= ~bit;
+    game->left_seats &= ~bit;
+    if (status == PLAYER_ACTIVE)
+        game->active_seats |= bit;
+    else if (status == PLAYER_ALLIN)
+        game->allin_seats |= bit;
+    else if (status == PLAYER_LEFT)
+        game->left_seats |= bit;
+}
+
+seat_mask_t funded_seats(const game_state_t *game)
+{
+    seat_mask_t funded = 0;
+    for (int i = 0; i < game->num_players; i++)
+    {
+        if (game->player_status[i] != PLAYER_LEFT && game->player_stacks[i] > 0)
+            funded |= SEAT_BIT(i);
     }
+    return funded;
+}
 
-    return 0;
+void recount_seats(game_state_t *game)
+{
+    game->active_seats = 0;
+    game->allin_seats = 0;
+    game->left_seats = 0;
+    game->matched_seats = 0;
+    for (int i = 0; i < game->num_players; i++)
+    {
+        set_player_status(game, i, game->player_status[i]);
+        if (game->current_bets[i] == game->highest_bet)
+            game->matched_seats |= SEAT_BIT(i);
+    }
 }
 
 // Returns 1 if all bets are the same among active players
 int check_betting_end(game_state_t *game)
 {
-    for (int i = 0; i < game->num_players; i++)
+    return (game->active_seats & ~game->matched_seats) == 0;
+}
+
+// Logs the community cards dealt for the current street
+void server_community(game_state_t *game)
+{
+    switch (game->round_stage)
     {
-        if (game->player_status[i] == PLAYER_ACTIVE &&
-            game->current_bets[i] != game->highest_bet)
-        {
-            return 0;
-        }
+    case ROUND_FLOP:
+        log_info("Dealt FLOP: %s %s %s",
+                 card_name(game->community_cards[0]),
+                 card_name(game->community_cards[1]),
+                 card_name(game->community_cards[2]));
+        break;
+    case ROUND_TURN:
+        log_info("Dealt TURN: %s", card_name(game->community_cards[3]));
+        break;
+    case ROUND_RIVER:
+        log_info("Dealt RIVER: %s", card_name(game->community_cards[4]));
+        break;
+    default:
+        break;
     }
-    return 1;
 }
 
-void server_community(game_state_t *game)
+// Announces the end of the hand, the engine already paid the pot to winner
+void server_end(game_state_t *game, player_id_t winner)
 {
-    // switch (game->round_stage)
-    // {
-    // case ROUND_FLOP:
-    //     printf("Dealing flop: %s %s %s\n",
-    //            card_name(game->community_cards[0]),
-    //            card_name(game->community_cards[1]),
-    //            card_name(game->community_cards[2]));
-    //     break;
-    // case ROUND_TURN:
-    //     printf("Dealing turn: %s\n",
-    //            card_name(game->community_cards[3]));
-    //     break;
-    // case ROUND_RIVER:
-    //     printf("Dealing river: %s\n",
-    //            card_name(game->community_cards[4]));
-    //     break;
-    // default:
-    //     break;
-    // }
-    (void)game;
-}
-
-void server_end(game_state_t *game)
-{
-    int winner = find_winner(game);
     printf("\n=== Game Over ===\n");
     if (winner >= 0)
     {
@@ -327,7 +546,6 @@ void server_end(game_state_t *game)
             printf("%s ", card_name(game->community_cards[i]));
         }
         printf("\nWinning pot: %d\n", game->pot_size);
-        game->player_stacks[winner] += game->pot_size;
     }
 
     server_packet_t end_pkt;
@@ -342,26 +560,22 @@ void server_end(game_state_t *game)
     }
 }
 
-// Helper function to sort cards by rank
-static void sort_cards(card_t cards[], int n)
+card_set_t player_card_set(game_state_t *game, player_id_t pid)
 {
-    for (int i = 0; i < n - 1; i++)
-    {
-        for (int j = 0; j < n - i - 1; j++)
-        {
-            if (RANK(cards[j]) > RANK(cards[j + 1]))
-            {
-                card_t temp = cards[j];
-                cards[j] = cards[j + 1];
-                cards[j + 1] = temp;
-            }
-        }
-    }
+    return card_set_from_cards(game->player_hands[pid], HAND_SIZE);
 }
 
-int evaluate_hand(game_state_t *game, player_id_t pid)
+card_set_t board_card_set(game_state_t *game)
+{
+    return card_set_from_cards(game->community_cards, MAX_COMMUNITY_CARDS);
+}
+
+#ifdef LEGACY_EVAL
+// Original sort-and-scan evaluator, kept for comparison (build with LEGACY_EVAL=1)
+
+// Gathers the hole cards of pid and the community cards, returns how many there are
+static int collect_cards(game_state_t *game, player_id_t pid, card_t cards[HAND_SIZE + MAX_COMMUNITY_CARDS])
 {
-    card_t cards[7]; // 2 hole cards + 5 community cards
     int num_cards = 0;
 
     // Collect hole cards
@@ -382,6 +596,31 @@ int evaluate_hand(game_state_t *game, player_id_t pid)
         }
     }
 
+    return num_cards;
+}
+
+// Helper function to sort cards by rank
+static void sort_cards(card_t cards[], int n)
+{
+    for (int i = 0; i < n - 1; i++)
+    {
+        for (int j = 0; j < n - i - 1; j++)
+        {
+            if (RANK(cards[j]) > RANK(cards[j + 1]))
+            {
+                card_t temp = cards[j];
+                cards[j] = cards[j + 1];
+                cards[j + 1] = temp;
+            }
+        }
+    }
+}
+
+int evaluate_hand(game_state_t *game, player_id_t pid)
+{
+    card_t cards[HAND_SIZE + MAX_COMMUNITY_CARDS];
+    int num_cards = collect_cards(game, pid, cards);
+
     if (num_cards < 5)
         return 0; // Not enough cards for evaluation
 
@@ -504,21 +743,247 @@ int evaluate_hand(game_state_t *game, player_id_t pid)
     return 1000000 + RANK(cards[num_cards - 1]);
 }
 
+#else
+
+// Table driven evaluator, see hand_eval.c
+int evaluate_hand(game_state_t *game, player_id_t pid)
+{
+    card_set_t hand = card_set_union(player_card_set(game, pid), board_card_set(game));
+
+    if (card_set_count(hand) < 5)
+        return 0; // Not enough cards for evaluation
+
+    return hand_eval_set(hand);
+}
+
+#endif
+
+// Bit k is set when the five ranks k - 1 .. k + 3 are all present, the ace also plays below the two
+static int straight_runs(int ranks)
+{
+    int r = (ranks << 1) | ((ranks >> (NUM_RANKS - 1)) & 1);
+    return r & (r >> 1) & (r >> 2) & (r >> 3) & (r >> 4);
+}
+
+// Bit r is set when one more card of rank r makes a straight that ranks alone do not have
+static int straight_completers(int ranks)
+{
+    if (straight_runs(ranks))
+        return 0;
+
+    int completers = 0;
+    for (int r = 0; r < NUM_RANKS; r++)
+    {
+        if (!(ranks & (1 << r)) && straight_runs(ranks | (1 << r)))
+            completers |= 1 << r;
+    }
+    return completers;
+}
+
+// Whether two more ranks can make a straight that uses at least one of the hole ranks
+static int backdoor_straight(int ranks, int board_ranks)
+{
+    int r = (ranks << 1) | ((ranks >> (NUM_RANKS - 1)) & 1);
+    int b = (board_ranks << 1) | ((board_ranks >> (NUM_RANKS - 1)) & 1);
+    for (int low = 0; low + 5 <= NUM_RANKS + 1; low++)
+    {
+        int window = 0x1f << low;
+        if (__builtin_popcount(r & window) == 3 && __builtin_popcount(b & window) < 3)
+            return 1;
+    }
+    return 0;
+}
+
+void analyze_draws(card_set_t hole, card_set_t board, draw_info_t *out)
+{
+    memset(out, 0, sizeof(draw_info_t));
+
+    int num_board = card_set_count(board);
+    if (num_board < 3 || num_board >= MAX_COMMUNITY_CARDS)
+        return; // Nothing to draw to before the flop or after the river
+
+    card_set_t hand = card_set_union(hole, board);
+    card_set_t unseen = card_set_minus(CARD_SET_DECK, hand);
+    int category = HAND_CATEGORY(hand_eval_set(hand));
+
+    // Flush draws, only for suites the hole cards take part in
+    int flush_suites = 0;
+    for (int s = 0; s < NUM_SUITES; s++)
+    {
+        int known = __builtin_popcount(card_set_suite(hand, s));
+        if (!card_set_suite(hole, s) || category >= HAND_FLUSH)
+            continue;
+        if (known == 4)
+        {
+            out->draws |= DRAW_FLUSH;
+            flush_suites |= 1 << s;
+        }
+        else if (known == 3 && num_board == 3)
+        {
+            out->draws |= DRAW_BACKDOOR_FLUSH;
+        }
+    }
+
+    // Straight draws, ranks that only complete a straight together with the hole cards
+    int ranks = card_set_ranks(hand), board_ranks = card_set_ranks(board);
+    if (category < HAND_STRAIGHT)
+    {
+        int completers = straight_completers(ranks) & ~straight_completers(board_ranks);
+        int num_completers = __builtin_popcount(completers);
+        if (num_completers >= 2)
+            out->draws |= DRAW_OPEN_ENDED;
+        else if (num_completers == 1)
+            out->draws |= DRAW_GUTSHOT;
+        else if (num_board == 3 && backdoor_straight(ranks, board_ranks))
+            out->draws |= DRAW_BACKDOOR_STRAIGHT;
+    }
+
+    // Outs: cards after which the hand is in a better category, and better than the board plays
+    // on its own. Away from a suite with four or more known cards every card of a rank scores the
+    // same, so each rank is valued once with one of those cards, and the few others one by one
+    card_set_t flush_cards = CARD_SET_EMPTY;
+    for (int s = 0; s < NUM_SUITES; s++)
+    {
+        if (__builtin_popcount(card_set_suite(hand, s)) >= 4)
+            flush_cards |= (card_set_t) CARD_SET_RANK_MASK << (s * CARD_SET_LANE_BITS);
+    }
+    flush_cards &= unseen;
+
+    for (int r = 0; r < NUM_RANKS; r++)
+    {
+        card_set_t rank_cards = unseen & ~flush_cards & (0x0001000100010001ULL << r);
+        if (!rank_cards)
+            continue;
+
+        card_set_t card = card_set_of(card_set_first(rank_cards));
+        int value = hand_eval_set(hand | card);
+        if (HAND_CATEGORY(value) > category && HAND_CATEGORY(value) > HAND_CATEGORY(hand_eval_set(board | card)))
+            out->out_cards |= rank_cards;
+    }
+    for (card_set_t rest = flush_cards; rest; rest &= rest - 1)
+    {
+        card_set_t card = rest & -rest;
+        int value = hand_eval_set(hand | card);
+        if (HAND_CATEGORY(value) > category && HAND_CATEGORY(value) > HAND_CATEGORY(hand_eval_set(board | card)))
+            out->out_cards |= card;
+    }
+    out->outs = card_set_count(out->out_cards);
+}
+
+int seat_draws(game_state_t *game, player_id_t pid, draw_info_t *out)
+{
+    // Only the cards the seat can see: its own hole cards and the community cards dealt so far
+    card_set_t board = card_set_from_cards(game->community_cards, game->community_dealt);
+    analyze_draws(player_card_set(game, pid), board, out);
+    return out->outs;
+}
+
+// Fills values with the hand value of every listed seat, one evaluation per seat
+static void value_seats(game_state_t *game, const player_id_t *seats, int num_seats, int values[MAX_PLAYERS])
+{
+#ifdef LEGACY_EVAL
+    for (int i = 0; i < num_seats; i++)
+    {
+        values[i] = evaluate_hand(game, seats[i]);
+    }
+#else
+    if (game->community_dealt == MAX_COMMUNITY_CARDS)
+    {
+        // The river has been dealt, so every hand was already valued as the board came out
+        for (int i = 0; i < num_seats; i++)
+        {
+            values[i] = game->hand_values[seats[i]];
+        }
+        return;
+    }
+
+    card_t board[MAX_COMMUNITY_CARDS];
+    int num_board = 0;
+    for (int i = 0; i < MAX_COMMUNITY_CARDS; i++)
+    {
+        if (game->community_cards[i] != NOCARD)
+            board[num_board++] = game->community_cards[i];
+    }
+    if (num_board + HAND_SIZE < 5)
+    {
+        // Not enough cards for evaluation, every hand is worth the same
+        memset(values, 0, num_seats * sizeof(int));
+        return;
+    }
+
+    // Otherwise score every seat in one batch call
+    card_t hole_cards[MAX_PLAYERS * HAND_SIZE];
+    for (int i = 0; i < num_seats; i++)
+    {
+        memcpy(&hole_cards[i * HAND_SIZE], game->player_hands[seats[i]], sizeof(game->player_hands[seats[i]]));
+    }
+    hand_eval_batch_board(hole_cards, num_seats, board, num_board, values);
+#endif
+}
+
+// Lists the seats still in the hand (active or all in) in seat order, straight from the masks
+static int live_seats(const game_state_t *game, player_id_t seats[MAX_PLAYERS])
+{
+    int num_seats = 0;
+    for (seat_mask_t live = game->active_seats | game->allin_seats; live; live &= live - 1)
+    {
+        seats[num_seats++] = __builtin_ctz(live);
+    }
+    return num_seats;
+}
+
 int find_winner(game_state_t *game)
 {
     // We wrote this function that looks at the game state and returns the player id for the best 5 card hand.
-    int best = -1, best_val = -1;
-    for (int i = 0; i < game->num_players; i++)
+    // All in seats are still in the hand, so they are scored too, the same seats rank_hands orders
+    player_id_t seats[MAX_PLAYERS] = {0};
+    int num_seats = live_seats(game, seats);
+
+    int values[MAX_PLAYERS];
+    value_seats(game, seats, num_seats, values);
+
+    // Ties go to the lowest seat
+    int best = -1;
+    for (int i = 0; i < num_seats; i++)
     {
-        if (game->player_status[i] == PLAYER_ACTIVE)
+        if (best < 0 || values[i] > values[best])
+            best = i;
+    }
+    return best < 0 ? -1 : seats[best];
+}
+
+int rank_hands(game_state_t *game, hand_ranking_t *ranking)
+{
+    // Pack every live seat into one key, higher keys rank first and equal hands keep seat order
+    uint32_t keys[MAX_PLAYERS];
+    player_id_t seats[MAX_PLAYERS] = {0};
+    int num_seats = live_seats(game, seats);
+
+    int values[MAX_PLAYERS];
+    value_seats(game, seats, num_seats, values);
+
+    for (int i = 0; i < num_seats; i++)
+    {
+        uint32_t key = (uint32_t) values[i] << RANKING_SEAT_BITS | (RANKING_SEAT_MASK - seats[i]);
+        int j = i;
+        for (; j > 0 && keys[j - 1] < key; j--)
         {
-            int val = evaluate_hand(game, i);
-            if (val > best_val)
-            {
-                best_val = val;
-                best = i;
-            }
+            keys[j] = keys[j - 1];
         }
+        keys[j] = key;
+    }
+
+    // Unpack in order, a new tie group starts wherever the hand value changes
+    ranking->num_seats = num_seats;
+    ranking->num_groups = 0;
+    for (int i = 0; i < num_seats; i++)
+    {
+        ranking->order[i] = RANKING_SEAT_MASK - (keys[i] & RANKING_SEAT_MASK);
+        ranking->values[i] = keys[i] >> RANKING_SEAT_BITS;
+        if (i == 0 || ranking->values[i] != ranking->values[i - 1])
+            ranking->group_start[ranking->num_groups++] = i;
+        ranking->group[i] = ranking->num_groups - 1;
     }
-    return best;
+    ranking->group_start[ranking->num_groups] = num_seats;
+    return num_seats;
 }
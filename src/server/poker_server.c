@@ -77,16 +77,13 @@ int main(int argc, char **argv)
             exit(EXIT_FAILURE);
         }
         game.sockets[player_count] = fd;
-        game.player_status[player_count++] = PLAYER_ACTIVE;
+        set_player_status(&game, player_count++, PLAYER_ACTIVE);
         log_info("Player connected on port %d (socket %d).", BASE_PORT + port, fd);
     }
     game.num_players = player_count;
 
     // Log active players
-    int active_players = 0;
-    for (int i = 0; i < game.num_players; i++)
-        if (game.player_status[i] == PLAYER_ACTIVE)
-            active_players++;
+    int active_players = seat_count(game.active_seats);
     log_info("Number of active players: %d", active_players);
 
     // JOIN and READY
@@ -113,141 +110,18 @@ int main(int argc, char **argv)
                 goto cleanup;
             }
             server_deal(&game);
-            game.round_stage = ROUND_PREFLOP;
             break;
 
         case ROUND_PREFLOP:
         case ROUND_FLOP:
         case ROUND_TURN:
         case ROUND_RIVER:
-        {
-            // Deal community cards
-            if (game.round_stage == ROUND_FLOP)
-            {
-                game.community_cards[0] = game.deck[game.next_card++];
-                game.community_cards[1] = game.deck[game.next_card++];
-                game.community_cards[2] = game.deck[game.next_card++];
-                log_info("Dealt FLOP: %s %s %s",
-                         card_name(game.community_cards[0]),
-                         card_name(game.community_cards[1]),
-                         card_name(game.community_cards[2]));
-            }
-            else if (game.round_stage == ROUND_TURN)
-            {
-                game.community_cards[3] = game.deck[game.next_card++];
-                log_info("Dealt TURN: %s", card_name(game.community_cards[3]));
-            }
-            else if (game.round_stage == ROUND_RIVER)
-            {
-                game.community_cards[4] = game.deck[game.next_card++];
-                log_info("Dealt RIVER: %s", card_name(game.community_cards[4]));
-            }
-
-            // Broadcast INFO to all
-            for (int i = 0; i < game.num_players; i++)
-            {
-                if (game.player_status[i] == PLAYER_ACTIVE)
-                {
-                    server_packet_t info_pkt;
-                    build_info_packet(&game, i, &info_pkt);
-                    send(game.sockets[i], &info_pkt, sizeof(info_pkt), 0);
-                    log_info("Sent INFO packet to player %d.", i);
-                }
-            }
-
-            // FIX: enforce full round before breaking on equal bets
-            int still_in = 0;
-            for (int i = 0; i < game.num_players; i++)
-                if (game.player_status[i] == PLAYER_ACTIVE)
-                    still_in++;
-            int actions = 0;
-
-            // Betting loop
-            while (1)
-            {
-                // Send turn-specific INFO
-                server_packet_t info_pkt;
-                build_info_packet(&game, game.current_player, &info_pkt);
-                send(game.sockets[game.current_player], &info_pkt, sizeof(info_pkt), 0);
-
-                // Receive action
-                client_packet_t in;
-                ssize_t bytes = recv(game.sockets[game.current_player], &in, sizeof(in), 0);
-                if (bytes <= 0)
-                {
-                    log_info("Player %d disconnected. Marked as LEFT.", game.current_player);
-                    game.player_status[game.current_player] = PLAYER_LEFT;
-                    close(game.sockets[game.current_player]);
-                    game.sockets[game.current_player] = -1;
-                    continue;
-                }
-
-                server_packet_t resp;
-                if (handle_client_action(&game, game.current_player, &in, &resp) == 0)
-                {
-                    send(game.sockets[game.current_player], &resp, sizeof(resp), 0);
-                    if (resp.packet_type == ACK)
-                        actions++;
-                }
-                else
-                {
-                    resp.packet_type = NACK;
-                    send(game.sockets[game.current_player], &resp, sizeof(resp), 0);
-                    continue;
-                }
-
-                // Log state
-                log_info("Game state after action:");
-                log_info("Pot size: %d", game.pot_size);
-                log_info("Highest bet: %d", game.highest_bet);
-                for (int i = 0; i < game.num_players; i++)
-                {
-                    log_info("Player %d: stack=%d, bet=%d, status=%d",
-                             i, game.player_stacks[i], game.current_bets[i], game.player_status[i]);
-                }
-
-                // Check for showdown
-                still_in = 0;
-                for (int i = 0; i < game.num_players; i++)
-                    if (game.player_status[i] == PLAYER_ACTIVE)
-                        still_in++;
-                if (still_in <= 1)
-                {
-                    game.round_stage = ROUND_SHOWDOWN;
-                    break;
-                }
-
-                // Only break if all bets equal AND full rotation
-                int all_equal = 1;
-                for (int i = 0; i < game.num_players; i++)
-                {
-                    if (game.player_status[i] == PLAYER_ACTIVE && game.current_bets[i] != game.highest_bet)
-                    {
-                        all_equal = 0;
-                        break;
-                    }
-                }
-                if (all_equal && actions >= still_in)
-                {
-                    break;
-                }
-
-                // Advance turn
-                do
-                {
-                    game.current_player = (game.current_player + 1) % game.num_players;
-                } while (game.player_status[game.current_player] != PLAYER_ACTIVE);
-                log_info("Next player turn: %d", game.current_player);
-            }
-
-            // Next stage
-            game.round_stage++;
+            // the engine moves the stage on, to the next street or straight to the showdown
+            server_bet(&game);
             break;
-        }
 
         case ROUND_SHOWDOWN:; // empty statement to allow declarations
             int still_in;
-            server_end(&game);
             {
                 int ready_count = 0;
                 int ready[MAX_PLAYERS] = {0};
@@ -269,7 +143,7 @@ int main(int argc, char **argv)
                             }
                             else if (in.packet_type == LEAVE)
                             {
-                                game.player_status[i] = PLAYER_LEFT;
+                                set_player_status(&game, i, PLAYER_LEFT);
                                 ready[i] = 1;
                                 ready_count++;
                                 log_info("Player %d has LEFT.", i);
@@ -280,23 +154,21 @@ int main(int argc, char **argv)
                     }
                 }
 
-                // Count remaining
-                still_in = 0;
-                for (int i = 0; i < game.num_players; i++)
-                    if (game.player_status[i] == PLAYER_ACTIVE)
-                        still_in++;
+                // Count the seats that can play the next hand, busted seats sit out but still get the HALT
+                seat_mask_t seated = SEATS_BELOW(game.num_players) & ~game.left_seats;
+                still_in = seat_count(funded_seats(&game));
                 if (still_in < 2)
                 {
                     for (int i = 0; i < game.num_players; i++)
                     {
-                        if (game.player_status[i] == PLAYER_ACTIVE)
+                        if (seated & SEAT_BIT(i))
                         {
                             server_packet_t halt_pkt;
                             memset(&halt_pkt, 0, sizeof(halt_pkt));
                             halt_pkt.packet_type = HALT;
                             send(game.sockets[i], &halt_pkt, sizeof(halt_pkt), 0);
                             close(game.sockets[i]);
-                            game.player_status[i] = PLAYER_LEFT;
+                            set_player_status(&game, i, PLAYER_LEFT);
                         }
                     }
                     goto cleanup;
@@ -0,0 +1,267 @@
+/**
+ * generates the preflop equity table loaded by preflop_table.c
+ *
+ * usage: server.preflop_gen OUTPUT [SAMPLES] [THREADS]
+ *
+ * every entry is a Monte Carlo estimate over SAMPLES runouts, where the concrete
+ * suits of each class are drawn at random as well. work is handed out one row at a
+ * time to THREADS workers (default: every online core), and every row has its own
+ * random stream so the output does not depend on the number of threads.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "preflop_table.h"
+#include "hand_eval.h"
+#include "card_set.h"
+#include "rng.h"
+#include "parallel.h"
+
+#define DEFAULT_SAMPLES 10000
+#define TABLE_SEED 0x70726566ULL
+#define DATA_ALIGN 64
+
+// rows 0 .. 168 are heads up rows, the next 169 are multiway rows
+#define NUM_WORK_ITEMS (2 * PREFLOP_CLASSES)
+
+static float heads_up[PREFLOP_CLASSES][PREFLOP_CLASSES];
+static float multiway[MAX_PLAYERS - 1][PREFLOP_CLASSES];
+
+static long samples = DEFAULT_SAMPLES;
+static atomic_int next_item = 0;
+
+static int random_other_suite(rng_t *rng, int suite)
+{
+    return (suite + 1 + rng_below(rng, NUM_SUITES - 1)) % NUM_SUITES;
+}
+
+// draws one concrete hand of the class
+static void sample_hand(rng_t *rng, int cls, card_t hand[2])
+{
+    int row = cls / 13, col = cls % 13;
+    int s1 = rng_below(rng, NUM_SUITES);
+
+    if (row == col)
+    {
+        hand[0] = (row << SUITE_BITS) | s1;
+        hand[1] = (row << SUITE_BITS) | random_other_suite(rng, s1);
+    }
+    else if (row > col)
+    {
+        hand[0] = (row << SUITE_BITS) | s1;
+        hand[1] = (col << SUITE_BITS) | s1;
+    }
+    else
+    {
+        hand[0] = (col << SUITE_BITS) | s1;
+        hand[1] = (row << SUITE_BITS) | random_other_suite(rng, s1);
+    }
+}
+
+static card_t draw_unused(rng_t *rng, card_set_t *used)
+{
+    card_t card;
+    do
+    {
+        card = rng_below(rng, DECK_SIZE);
+    } while (card_set_contains(*used, card));
+    *used = card_set_add(*used, card);
+    return card;
+}
+
+// deals a random board on top of used and returns it as an incremental hand
+static hand_eval_state_t sample_board(rng_t *rng, card_set_t used)
+{
+    hand_eval_state_t board;
+    hand_eval_state_init(&board);
+    for (int i = 0; i < 5; i++)
+    {
+        hand_eval_state_add(&board, draw_unused(rng, &used));
+    }
+    return board;
+}
+
+static int hand_value(const hand_eval_state_t *board, const card_t hand[2])
+{
+    hand_eval_state_t full = *board;
+    hand_eval_state_add(&full, hand[0]);
+    hand_eval_state_add(&full, hand[1]);
+    return hand_eval_state_value(&full);
+}
+
+static void compute_heads_up_row(int a, rng_t *rng)
+{
+    // a class against itself wins as often as it loses
+    heads_up[a][a] = 0.5f;
+
+    for (int b = a + 1; b < PREFLOP_CLASSES; b++)
+    {
+        double won = 0;
+        for (long n = 0; n < samples; n++)
+        {
+            card_t hand_a[2], hand_b[2];
+            card_set_t used;
+
+            // redraw both hands on a clash so every pair of hands is equally likely
+            do
+            {
+                sample_hand(rng, a, hand_a);
+                sample_hand(rng, b, hand_b);
+                used = card_set_from_cards(hand_a, 2) | card_set_from_cards(hand_b, 2);
+            } while (card_set_count(used) != 4);
+
+            hand_eval_state_t board = sample_board(rng, used);
+            int value_a = hand_value(&board, hand_a);
+            int value_b = hand_value(&board, hand_b);
+            won += value_a > value_b ? 1.0 : value_a == value_b ? 0.5 : 0.0;
+        }
+
+        heads_up[a][b] = (float) (won / samples);
+        heads_up[b][a] = (float) (1.0 - won / samples);
+    }
+}
+
+static void compute_multiway_row(int cls, rng_t *rng)
+{
+    for (int num_players = 2; num_players <= MAX_PLAYERS; num_players++)
+    {
+        double won = 0;
+        for (long n = 0; n < samples; n++)
+        {
+            card_t hero[2];
+            sample_hand(rng, cls, hero);
+            card_set_t used = card_set_from_cards(hero, 2);
+
+            card_t opponents[MAX_PLAYERS - 1][2];
+            for (int p = 0; p < num_players - 1; p++)
+            {
+                opponents[p][0] = draw_unused(rng, &used);
+                opponents[p][1] = draw_unused(rng, &used);
+            }
+
+            hand_eval_state_t board = sample_board(rng, used);
+            int hero_value = hand_value(&board, hero);
+            int ties = 1;
+            int lost = 0;
+            for (int p = 0; p < num_players - 1 && !lost; p++)
+            {
+                int value = hand_value(&board, opponents[p]);
+                if (value > hero_value)
+                    lost = 1;
+                else if (value == hero_value)
+                    ties++;
+            }
+            if (!lost)
+                won += 1.0 / ties;
+        }
+
+        multiway[num_players - 2][cls] = (float) (won / samples);
+    }
+}
+
+static void *worker(void *arg)
+{
+    (void) arg;
+    int item;
+    while ((item = atomic_fetch_add(&next_item, 1)) < NUM_WORK_ITEMS)
+    {
+        rng_t rng;
+        rng_seed(&rng, TABLE_SEED ^ ((uint64_t) item * 0x9e3779b97f4a7c15ULL));
+
+        if (item < PREFLOP_CLASSES)
+            compute_heads_up_row(item, &rng);
+        else
+            compute_multiway_row(item - PREFLOP_CLASSES, &rng);
+    }
+    return NULL;
+}
+
+static int write_table(const char *path)
+{
+    preflop_table_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, PREFLOP_TABLE_MAGIC, sizeof(PREFLOP_TABLE_MAGIC));
+    header.version = PREFLOP_TABLE_VERSION;
+    header.num_classes = PREFLOP_CLASSES;
+    header.max_players = MAX_PLAYERS;
+    header.samples = (uint32_t) samples;
+    header.heads_up_offset = DATA_ALIGN;
+    header.multiway_offset = DATA_ALIGN + sizeof(heads_up);
+
+    // write next to the old table and swap it in, processes that still map the old file keep their copy
+    char tmp_path[4096];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    FILE *file = fopen(tmp_path, "wb");
+    if (!file)
+        return -1;
+
+    char padding[DATA_ALIGN] = { 0 };
+    int ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+             fwrite(padding, DATA_ALIGN - sizeof(header), 1, file) == 1 &&
+             fwrite(heads_up, sizeof(heads_up), 1, file) == 1 &&
+             fwrite(multiway, sizeof(multiway), 1, file) == 1;
+    ok = fclose(file) == 0 && ok;
+
+    if (!ok || rename(tmp_path, path) != 0)
+    {
+        remove(tmp_path);
+        return -1;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2 || argc > 4)
+    {
+        fprintf(stderr, "usage: %s OUTPUT [SAMPLES] [THREADS]\n", argv[0]);
+        return 1;
+    }
+
+    if (argc >= 3)
+        samples = atol(argv[2]);
+    int num_threads = argc >= 4 ? atoi(argv[3]) : default_threads();
+    if (samples <= 0 || num_threads <= 0)
+    {
+        fprintf(stderr, "samples and threads must be positive.\n");
+        return 1;
+    }
+    num_threads = thread_count(num_threads, 0);
+
+    hand_eval_init();
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    // the workers take rows off a shared counter, so a thread that could not be started
+    // only means fewer hands. the calling thread works too
+    pthread_t threads[num_threads];
+    int started[num_threads];
+    for (int t = 0; t < num_threads - 1; t++)
+    {
+        started[t] = pthread_create(&threads[t], NULL, worker, NULL) == 0;
+    }
+    worker(NULL);
+    for (int t = 0; t < num_threads - 1; t++)
+    {
+        if (started[t])
+            pthread_join(threads[t], NULL);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    if (write_table(argv[1]) == -1)
+    {
+        perror("write table");
+        return 1;
+    }
+
+    printf("Wrote %s (%ld samples per entry, %d threads, %.1f s)\n", argv[1], samples, num_threads, seconds);
+    return 0;
+}
@@ -0,0 +1,93 @@
+#include <string.h>
+
+#include "side_pots.h"
+
+int build_side_pots(const game_state_t *game, side_pots_t *pots)
+{
+    memset(pots, 0, sizeof(side_pots_t));
+    pots->main_winner = -1;
+
+    // the distinct contributions of the seats still in, lowest first
+    seat_mask_t live = game->active_seats | game->allin_seats;
+    int levels[MAX_PLAYERS];
+    int num_levels = 0;
+    for (int i = 0; i < game->num_players; i++)
+    {
+        if (!(live & SEAT_BIT(i)))
+            continue;
+        int level = game->current_bets[i];
+        int j = 0;
+        while (j < num_levels && levels[j] < level)
+            j++;
+        if (j < num_levels && levels[j] == level)
+            continue;
+        memmove(&levels[j + 1], &levels[j], (num_levels - j) * sizeof(int));
+        levels[j] = level;
+        num_levels++;
+    }
+
+    int floor = 0;
+    for (int l = 0; l < num_levels; l++)
+    {
+        int level = levels[l];
+        int top = l == num_levels - 1;
+        int amount = 0;
+        seat_mask_t eligible = 0;
+        for (int i = 0; i < game->num_players; i++)
+        {
+            int bet = game->current_bets[i];
+            int upto = top || bet < level ? bet : level;
+            if (upto > floor)
+                amount += upto - floor;
+            if ((live & SEAT_BIT(i)) && bet >= level)
+                eligible |= SEAT_BIT(i);
+        }
+        floor = level;
+
+        // a level nobody put chips in (seats still in that never bet) makes no pot
+        if (amount == 0)
+            continue;
+        pots->amounts[pots->num_pots] = amount;
+        pots->eligible[pots->num_pots] = eligible;
+        pots->num_pots++;
+    }
+    return pots->num_pots;
+}
+
+void award_side_pots(game_state_t *game, side_pots_t *pots)
+{
+    hand_ranking_t ranking;
+    rank_hands(game, &ranking);
+
+    // best hands first, every pot goes to the first group that can win it
+    int open = (1 << pots->num_pots) - 1;
+    for (int g = 0; g < ranking.num_groups && open; g++)
+    {
+        seat_mask_t group = 0;
+        for (int i = ranking.group_start[g]; i < ranking.group_start[g + 1]; i++)
+        {
+            group |= SEAT_BIT(ranking.order[i]);
+        }
+
+        for (int p = 0; p < pots->num_pots; p++)
+        {
+            seat_mask_t winners = group & pots->eligible[p];
+            if (!(open & (1 << p)) || !winners)
+                continue;
+            open &= ~(1 << p);
+
+            int share = pots->amounts[p] / seat_count(winners);
+            int odd = pots->amounts[p] % seat_count(winners);
+            if (p == 0)
+                pots->main_winner = __builtin_ctz(winners);
+            for (seat_mask_t rest = winners; rest; rest &= rest - 1)
+            {
+                pots->payouts[__builtin_ctz(rest)] += share + (odd-- > 0);
+            }
+        }
+    }
+
+    // a hand checked down has no pot, the best hand still wins it
+    if (pots->main_winner < 0 && ranking.num_groups > 0)
+        pots->main_winner = ranking.order[ranking.group_start[0]];
+}
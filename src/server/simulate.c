@@ -0,0 +1,402 @@
+/**
+ * headless self-play: whole tables played in memory through the engine, no sockets
+ *
+ * usage: server.simulate [HANDS] [POLICIES] [THREADS] [SEED] [OUTPUT]
+ *
+ * POLICIES is a comma separated list of seat policies (passive, random, tight or
+ * aggressive, default tight,random,passive,aggressive,tight,random), repeated over the
+ * seats when shorter than a table. every one of THREADS workers (default: every online
+ * core) plays TABLES_PER_THREAD tables in turn until HANDS hands (default 1000000) are
+ * played overall. tables shuffle lazily from their own stream of SEED, so a run is
+ * repeatable for the same arguments.
+ *
+ * a seat that drops below REBUY_BELOW chips buys back in to the starting stack. the
+ * results per policy (chips won per 100 hands, share of pots won) and the hand rate are
+ * printed. with OUTPUT, every seat of every hand is also written as a CSV line (table,
+ * hand, seat, policy, hole cards, board, last street, chips won) for training data.
+ * make simulate builds it with optimizations, the level is printed with the hand rate.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "game_logic.h"
+#include "engine.h"
+#include "hand_eval.h"
+#include "rng.h"
+#include "platform.h"
+#include "parallel.h"
+
+#define DEFAULT_HANDS 1000000
+#define DEFAULT_SEED 0x73696d756c617465ULL
+#define DEFAULT_POLICIES "tight,random,passive,aggressive,tight,random"
+#define TABLES_PER_THREAD 8
+#define STARTING_STACK 100
+#define REBUY_BELOW 20
+#define OUTPUT_BUFFER (1 << 16)
+#define MAX_LINE 128
+
+typedef void (*policy_fn_t)(const game_state_t *game, player_id_t seat, rng_t *rng, engine_action_t *out);
+
+typedef struct {
+    const char *name;
+    policy_fn_t act;
+} policy_t;
+
+typedef struct {
+    long hands;                                     // hands dealt in
+    long net;                                       // chips won minus chips lost
+    long pots;                                      // pots won
+} seat_tally_t;
+
+typedef struct {
+    long hands_to_play;
+    int first_table;
+    seat_tally_t seats[MAX_PLAYERS];
+    long showdowns;                                 // hands that went to the river
+    long rejected;                                  // policy actions the engine refused
+    long rebuys;
+    char *buffer;                                   // CSV lines not written yet, NULL without OUTPUT
+    size_t buffered;
+} __attribute__((aligned(CACHE_LINE))) sim_worker_t;
+
+static const policy_t *seat_policies[MAX_PLAYERS];
+static uint64_t sim_seed;
+static FILE *output;
+static pthread_mutex_t output_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// -------------------------------- policies -------------------------------- //
+
+static int to_call(const game_state_t *game, player_id_t seat)
+{
+    return game->highest_bet - game->current_bets[seat];
+}
+
+static void set_action(engine_action_t *out, client_packet_type_t type, int amount)
+{
+    out->type = type;
+    out->amount = amount;
+}
+
+// checks when it can, calls anything else
+static void policy_passive(const game_state_t *game, player_id_t seat, rng_t *rng, engine_action_t *out)
+{
+    set_action(out, to_call(game, seat) > 0 ? CALL : CHECK, 0);
+}
+
+static void policy_random(const game_state_t *game, player_id_t seat, rng_t *rng, engine_action_t *out)
+{
+    static const client_packet_type_t actions[] = { FOLD, CHECK, CALL, RAISE };
+    set_action(out, actions[rng_below(rng, 4)], 1 + rng_below(rng, 10));
+}
+
+// raises good hands, calls fair ones and gives up the rest
+static void policy_tight(const game_state_t *game, player_id_t seat, rng_t *rng, engine_action_t *out)
+{
+    int strength;
+    if (game->community_dealt == 0)
+    {
+        int high = RANK(game->player_hands[seat][0]), low = RANK(game->player_hands[seat][1]);
+        if (high < low)
+        {
+            int temp = high;
+            high = low;
+            low = temp;
+        }
+        strength = high == low ? 2 : (low >= RANK(TEN) || high == RANK(ACE)) ? 1 : 0;
+    }
+    else
+    {
+        int category = HAND_CATEGORY(game->hand_values[seat]);
+        strength = category >= HAND_TWO_PAIR ? 2 : category == HAND_ONE_PAIR ? 1 : 0;
+    }
+
+    if (strength == 2)
+        set_action(out, RAISE, 4 + rng_below(rng, 6));
+    else if (strength == 1 || to_call(game, seat) == 0)
+        set_action(out, to_call(game, seat) > 0 ? CALL : CHECK, 0);
+    else
+        set_action(out, FOLD, 0);
+}
+
+static void policy_aggressive(const game_state_t *game, player_id_t seat, rng_t *rng, engine_action_t *out)
+{
+    if (rng_below(rng, 2))
+        set_action(out, RAISE, 2 + rng_below(rng, 8));
+    else
+        policy_passive(game, seat, rng, out);
+}
+
+static const policy_t policies[] = {
+    { "passive", policy_passive },
+    { "random", policy_random },
+    { "tight", policy_tight },
+    { "aggressive", policy_aggressive },
+};
+
+#define NUM_POLICIES ((int) (sizeof(policies) / sizeof(policies[0])))
+
+static const policy_t *find_policy(const char *name, size_t length)
+{
+    for (int p = 0; p < NUM_POLICIES; p++)
+    {
+        if (strlen(policies[p].name) == length && strncmp(policies[p].name, name, length) == 0)
+            return &policies[p];
+    }
+    return NULL;
+}
+
+// --------------------------------- tables --------------------------------- //
+
+static void flush_output(sim_worker_t *worker)
+{
+    if (!worker->buffered)
+        return;
+    pthread_mutex_lock(&output_lock);
+    fwrite(worker->buffer, 1, worker->buffered, output);
+    pthread_mutex_unlock(&output_lock);
+    worker->buffered = 0;
+}
+
+static void record_hand(sim_worker_t *worker, const game_state_t *game, int table, long hand, const int *net)
+{
+    char board[3 * MAX_COMMUNITY_CARDS + 1] = "";
+    for (int i = 0; i < game->community_dealt; i++)
+    {
+        strcat(board, card_name(game->community_cards[i]));
+    }
+
+    for (int seat = 0; seat < game->num_players; seat++)
+    {
+        if (worker->buffered + MAX_LINE > OUTPUT_BUFFER)
+            flush_output(worker);
+        worker->buffered += snprintf(worker->buffer + worker->buffered, MAX_LINE, "%d,%ld,%d,%s,%s%s,%s,%d,%d\n",
+                                     table, hand, seat, seat_policies[seat]->name,
+                                     card_name(game->player_hands[seat][0]), card_name(game->player_hands[seat][1]),
+                                     board, game->community_dealt, net[seat]);
+    }
+}
+
+// asks the policy of the seat to act, falling back to a call, a check and a fold if the engine refuses
+static void take_turn(sim_worker_t *worker, game_state_t *game, rng_t *rng, engine_events_t *events)
+{
+    player_id_t seat = game->current_player;
+    engine_action_t action;
+    seat_policies[seat]->act(game, seat, rng, &action);
+    if (engine_apply(game, seat, &action, events) == 0)
+        return;
+
+    worker->rejected++;
+    static const client_packet_type_t fallbacks[] = { CALL, CHECK, FOLD };
+    for (int f = 0; f < 3; f++)
+    {
+        set_action(&action, fallbacks[f], 0);
+        if (engine_apply(game, seat, &action, events) == 0)
+            return;
+    }
+}
+
+static void play_hand(sim_worker_t *worker, game_state_t *game, rng_t *rng, int table, long hand)
+{
+    int stacks_before[MAX_PLAYERS];
+    for (int seat = 0; seat < game->num_players; seat++)
+    {
+        if (game->player_stacks[seat] < REBUY_BELOW)
+        {
+            game->player_stacks[seat] = STARTING_STACK;
+            worker->rebuys++;
+        }
+        stacks_before[seat] = game->player_stacks[seat];
+    }
+
+    reset_game_state(game);
+    game->dealer_player = (int) (hand % game->num_players);
+    game->current_player = (game->dealer_player + 1) % game->num_players;
+
+    engine_events_t events;
+    engine_start_hand(game, &events);
+    while (game->round_stage != ROUND_SHOWDOWN)
+    {
+        take_turn(worker, game, rng, &events);
+    }
+
+    int winner = events.events[events.count - 1].seat;
+    if (game->community_dealt == MAX_COMMUNITY_CARDS)
+        worker->showdowns++;
+
+    int net[MAX_PLAYERS];
+    for (int seat = 0; seat < game->num_players; seat++)
+    {
+        net[seat] = game->player_stacks[seat] - stacks_before[seat];
+        worker->seats[seat].hands++;
+        worker->seats[seat].net += net[seat];
+    }
+    if (winner >= 0)
+        worker->seats[winner].pots++;
+    if (worker->buffer)
+        record_hand(worker, game, table, hand, net);
+}
+
+static void *worker_main(void *arg)
+{
+    sim_worker_t *worker = arg;
+    game_state_t *tables = malloc(TABLES_PER_THREAD * sizeof(game_state_t));
+    if (!tables)
+        return NULL;
+
+    rng_t rng;
+    rng_seed(&rng, sim_seed ^ (uint64_t) worker->first_table * 0x9e3779b97f4a7c15ULL);
+    for (int t = 0; t < TABLES_PER_THREAD; t++)
+    {
+        init_game_state(&tables[t], STARTING_STACK, 0);
+        deck_rng_seed(&tables[t].rng, DECK_RNG_LAZY, sim_seed + worker->first_table + t);
+        tables[t].round_stage = ROUND_INIT;
+    }
+
+    // the tables take turns, one hand each
+    for (long hand = 0; hand < worker->hands_to_play; hand++)
+    {
+        int t = (int) (hand % TABLES_PER_THREAD);
+        play_hand(worker, &tables[t], &rng, worker->first_table + t, hand / TABLES_PER_THREAD);
+    }
+
+    if (worker->buffer)
+        flush_output(worker);
+    free(tables);
+    return NULL;
+}
+
+// --------------------------------- driver --------------------------------- //
+
+static int parse_policies(const char *list)
+{
+    int count = 0;
+    const policy_t *parsed[MAX_PLAYERS];
+    while (*list)
+    {
+        size_t length = strcspn(list, ",");
+        const policy_t *policy = find_policy(list, length);
+        if (!policy || count == MAX_PLAYERS)
+            return -1;
+        parsed[count++] = policy;
+        list += length + (list[length] == ',');
+    }
+    if (count == 0)
+        return -1;
+
+    for (int seat = 0; seat < MAX_PLAYERS; seat++)
+    {
+        seat_policies[seat] = parsed[seat % count];
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 6)
+    {
+        fprintf(stderr, "usage: %s [HANDS] [POLICIES] [THREADS] [SEED] [OUTPUT]\n", argv[0]);
+        return 1;
+    }
+
+    long hands = argc >= 2 ? atol(argv[1]) : DEFAULT_HANDS;
+    const char *policy_list = argc >= 3 ? argv[2] : DEFAULT_POLICIES;
+    int num_threads = argc >= 4 ? atoi(argv[3]) : default_threads();
+    sim_seed = argc >= 5 ? strtoull(argv[4], NULL, 0) : DEFAULT_SEED;
+    const char *output_path = argc >= 6 ? argv[5] : NULL;
+
+    if (hands <= 0 || num_threads <= 0)
+    {
+        fprintf(stderr, "hands and threads must be positive.\n");
+        return 1;
+    }
+    if (parse_policies(policy_list) == -1)
+    {
+        fprintf(stderr, "bad policy list %s, expected up to %d of:", policy_list, MAX_PLAYERS);
+        for (int p = 0; p < NUM_POLICIES; p++)
+        {
+            fprintf(stderr, " %s", policies[p].name);
+        }
+        fprintf(stderr, "\n");
+        return 1;
+    }
+    if (output_path)
+    {
+        output = fopen(output_path, "w");
+        if (!output)
+        {
+            perror("open output");
+            return 1;
+        }
+        fprintf(output, "table,hand,seat,policy,hole,board,street_cards,net\n");
+    }
+
+    num_threads = thread_count(num_threads, hands);
+    hand_eval_init();
+
+    sim_worker_t *workers = aligned_alloc(CACHE_LINE, num_threads * sizeof(sim_worker_t));
+    if (!workers)
+    {
+        perror("malloc");
+        return 1;
+    }
+    memset(workers, 0, num_threads * sizeof(sim_worker_t));
+    for (int t = 0; t < num_threads; t++)
+    {
+        workers[t].hands_to_play = hands / num_threads + (t < hands % num_threads);
+        workers[t].first_table = t * TABLES_PER_THREAD;
+        if (output && !(workers[t].buffer = malloc(OUTPUT_BUFFER)))
+        {
+            perror("malloc");
+            return 1;
+        }
+    }
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    // the calling thread plays the last share itself
+    run_workers(worker_main, workers, sizeof(sim_worker_t), num_threads);
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    seat_tally_t seats[MAX_PLAYERS];
+    long showdowns = 0, rejected = 0, rebuys = 0;
+    memset(seats, 0, sizeof(seats));
+    for (int t = 0; t < num_threads; t++)
+    {
+        for (int s = 0; s < MAX_PLAYERS; s++)
+        {
+            seats[s].hands += workers[t].seats[s].hands;
+            seats[s].net += workers[t].seats[s].net;
+            seats[s].pots += workers[t].seats[s].pots;
+        }
+        showdowns += workers[t].showdowns;
+        rejected += workers[t].rejected;
+        rebuys += workers[t].rebuys;
+        free(workers[t].buffer);
+    }
+    free(workers);
+
+    printf("%-6s %-12s %14s %10s\n", "seat", "policy", "chips/100", "pots won");
+    for (int s = 0; s < MAX_PLAYERS; s++)
+    {
+        printf("%-6d %-12s %14.2f %9.2f%%\n", s, seat_policies[s]->name,
+               seats[s].hands ? 100.0 * seats[s].net / seats[s].hands : 0.0,
+               seats[s].hands ? 100.0 * seats[s].pots / seats[s].hands : 0.0);
+    }
+    printf("\n%ld hands in %.2f s with %d threads, %.0f hands/s (built with %s)\n", hands, seconds, num_threads,
+           hands / seconds, OPT_LEVEL);
+    printf("%.2f%% to the river, %ld refused actions, %ld rebuys\n", 100.0 * showdowns / hands, rejected, rebuys);
+
+    if (output && fclose(output) != 0)
+    {
+        perror("write output");
+        return 1;
+    }
+    return 0;
+}
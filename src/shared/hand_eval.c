@@ -0,0 +1,488 @@
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define HAND_EVAL_X86
+#endif
+
+#include "hand_eval.h"
+
+/**
+ * the evaluator splits a hand into its ranks and its suits
+ *
+ * ranks: every multiset of up to 7 ranks (at most 4 of each) is a state in a small
+ * automaton. adding a card is one read of rank_next[state][rank], and the value of the
+ * best non-flush hand for a state is stored in rank_value. the automaton does not care
+ * about the order the cards were added in.
+ *
+ * suits: a 13 bit rank mask is kept for every suite, and flush_value holds the best
+ * flush (or straight flush) for masks with at least 5 bits set and 0 otherwise. with
+ * 7 cards a flush can never share the hand with quads or a full house, so the best hand
+ * is simply the larger of the two values.
+ *
+ * short deck: the same automaton with a second pair of value tables. the ranks two to
+ * five never show up, the ace also sits below the six and flushes trade places with
+ * full houses. a flush still cannot share 7 cards with a full house or quads.
+ */
+
+#define MAX_EVAL_CARDS 7
+#define NUM_RANK_STATES 76155 // multisets of 0..7 ranks with at most 4 of each rank
+#define RANK_MASK_SIZE (1 << NUM_RANKS)
+
+static uint32_t rank_next[NUM_RANK_STATES][NUM_RANKS];
+static int rank_value[NUM_RANK_STATES];
+static int flush_value[RANK_MASK_SIZE];
+static int short_rank_value[NUM_RANK_STATES];
+static int short_flush_value[RANK_MASK_SIZE];
+
+// the rank counts of each state written as a base 5 number, in increasing order
+static uint32_t state_keys[NUM_RANK_STATES];
+static int num_states = 0;
+
+static pthread_once_t tables_once = PTHREAD_ONCE_INIT;
+static int use_avx2 = 0;
+
+static uint32_t pow5[NUM_RANKS];
+
+static int top_rank(int mask)
+{
+    return 31 - __builtin_clz(mask);
+}
+
+// writes the n highest ranks of mask into out, returns how many were written
+static int top_ranks(int mask, int n, int *out)
+{
+    int written = 0;
+    while (mask && written < n)
+    {
+        int r = top_rank(mask);
+        out[written++] = r;
+        mask &= ~(1 << r);
+    }
+    return written;
+}
+
+static int pack_value(hand_category_t category, const int *ranks, int n)
+{
+    int kickers = 0;
+    for (int i = 0; i < 5; i++)
+    {
+        kickers = (kickers << 4) | (i < n ? ranks[i] : 0);
+    }
+    return (category << HAND_CATEGORY_SHIFT) | kickers;
+}
+
+// the category a hand is stored under, a short deck flush outranks a full house
+static hand_category_t deck_category(hand_category_t category, int short_deck)
+{
+    if (short_deck && category == HAND_FLUSH)
+        return HAND_FULL_HOUSE;
+    if (short_deck && category == HAND_FULL_HOUSE)
+        return HAND_FLUSH;
+    return category;
+}
+
+// returns the rank of the highest card of the best straight in mask, or -1 if there is none
+static int straight_high(int mask, int short_deck)
+{
+    // shift everything up by one so the ace can also sit below the two (below the six in a short deck)
+    int low_ace = short_deck ? RANK(SIX) : 0;
+    int m = (mask << 1) | (((mask >> (NUM_RANKS - 1)) & 1) << low_ace);
+    int runs = m & (m >> 1) & (m >> 2) & (m >> 3) & (m >> 4);
+    if (!runs)
+        return -1;
+    return top_rank(runs) + 3;
+}
+
+// best non-flush hand given the ranks that appear at least once, exactly twice, three and four times
+static int eval_rank_masks(int present, int pairs, int trips, int quads, int short_deck)
+{
+    int ranks[5];
+    int n;
+
+    if (quads)
+    {
+        ranks[0] = top_rank(quads);
+        n = 1 + top_ranks(present & ~(1 << ranks[0]), 1, ranks + 1);
+        return pack_value(HAND_QUADS, ranks, n);
+    }
+
+    if (trips)
+    {
+        ranks[0] = top_rank(trips);
+        int rest = (trips & ~(1 << ranks[0])) | pairs;
+        if (rest)
+        {
+            ranks[1] = top_rank(rest);
+            return pack_value(deck_category(HAND_FULL_HOUSE, short_deck), ranks, 2);
+        }
+    }
+
+    int high = straight_high(present, short_deck);
+    if (high >= 0)
+        return pack_value(HAND_STRAIGHT, &high, 1);
+
+    if (trips)
+    {
+        n = 1 + top_ranks(present & ~trips, 2, ranks + 1);
+        return pack_value(HAND_TRIPS, ranks, n);
+    }
+
+    if (__builtin_popcount(pairs) >= 2)
+    {
+        top_ranks(pairs, 2, ranks);
+        n = 2 + top_ranks(present & ~(1 << ranks[0]) & ~(1 << ranks[1]), 1, ranks + 2);
+        return pack_value(HAND_TWO_PAIR, ranks, n);
+    }
+
+    if (pairs)
+    {
+        ranks[0] = top_rank(pairs);
+        n = 1 + top_ranks(present & ~pairs, 3, ranks + 1);
+        return pack_value(HAND_ONE_PAIR, ranks, n);
+    }
+
+    if (!present)
+        return 0;
+
+    n = top_ranks(present, 5, ranks);
+    return pack_value(HAND_HIGH_CARD, ranks, n);
+}
+
+static int eval_rank_counts(const int counts[NUM_RANKS], int short_deck)
+{
+    int present = 0, pairs = 0, trips = 0, quads = 0;
+    for (int r = 0; r < NUM_RANKS; r++)
+    {
+        if (counts[r] >= 1)
+            present |= 1 << r;
+        if (counts[r] == 2)
+            pairs |= 1 << r;
+        if (counts[r] == 3)
+            trips |= 1 << r;
+        if (counts[r] == 4)
+            quads |= 1 << r;
+    }
+    return eval_rank_masks(present, pairs, trips, quads, short_deck);
+}
+
+static int eval_flush_mask(int mask, int short_deck)
+{
+    if (__builtin_popcount(mask) < 5)
+        return 0;
+
+    int high = straight_high(mask, short_deck);
+    if (high >= 0)
+        return pack_value(HAND_STRAIGHT_FLUSH, &high, 1);
+
+    int ranks[5];
+    top_ranks(mask, 5, ranks);
+    return pack_value(deck_category(HAND_FLUSH, short_deck), ranks, 5);
+}
+
+// lists every state key in increasing order, starting from the most significant rank
+static void enumerate_states(int rank, int remaining, uint32_t key)
+{
+    if (rank < 0)
+    {
+        state_keys[num_states++] = key;
+        return;
+    }
+    for (int c = 0; c <= 4 && c <= remaining; c++)
+    {
+        enumerate_states(rank - 1, remaining - c, key + c * pow5[rank]);
+    }
+}
+
+static uint32_t find_state(uint32_t key)
+{
+    int lo = 0, hi = num_states - 1;
+    while (lo < hi)
+    {
+        int mid = (lo + hi) / 2;
+        if (state_keys[mid] < key)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+static void build_tables()
+{
+    pow5[0] = 1;
+    for (int r = 1; r < NUM_RANKS; r++)
+    {
+        pow5[r] = pow5[r - 1] * 5;
+    }
+
+    num_states = 0;
+    enumerate_states(NUM_RANKS - 1, MAX_EVAL_CARDS, 0);
+
+    for (int i = 0; i < num_states; i++)
+    {
+        int counts[NUM_RANKS];
+        int total = 0;
+        uint32_t key = state_keys[i];
+        for (int r = 0; r < NUM_RANKS; r++)
+        {
+            counts[r] = key % 5;
+            total += counts[r];
+            key /= 5;
+        }
+
+        rank_value[i] = eval_rank_counts(counts, 0);
+        short_rank_value[i] = eval_rank_counts(counts, 1);
+
+        // impossible transitions (a fifth card of a rank, an eighth card) lead back to the empty hand
+        for (int r = 0; r < NUM_RANKS; r++)
+        {
+            if (counts[r] < 4 && total < MAX_EVAL_CARDS)
+                rank_next[i][r] = find_state(state_keys[i] + pow5[r]);
+            else
+                rank_next[i][r] = 0;
+        }
+    }
+
+    for (int mask = 0; mask < RANK_MASK_SIZE; mask++)
+    {
+        flush_value[mask] = eval_flush_mask(mask, 0);
+        short_flush_value[mask] = eval_flush_mask(mask, 1);
+    }
+
+#ifdef HAND_EVAL_X86
+    __builtin_cpu_init();
+    use_avx2 = __builtin_cpu_supports("avx2");
+#endif
+}
+
+void hand_eval_init()
+{
+    pthread_once(&tables_once, build_tables);
+}
+
+void hand_eval_state_init(hand_eval_state_t *hand)
+{
+    memset(hand, 0, sizeof(hand_eval_state_t));
+}
+
+void hand_eval_state_add(hand_eval_state_t *hand, card_t card)
+{
+    hand->state = rank_next[hand->state][RANK(card)];
+    hand->suit_masks[SUITE(card)] |= 1 << RANK(card);
+}
+
+int hand_eval_state_value(const hand_eval_state_t *hand)
+{
+    int value = rank_value[hand->state];
+    for (int s = 0; s < NUM_SUITES; s++)
+    {
+        if (flush_value[hand->suit_masks[s]] > value)
+            value = flush_value[hand->suit_masks[s]];
+    }
+    return value;
+}
+
+int hand_eval_cards(const card_t *cards, int num_cards)
+{
+    hand_eval_state_t hand;
+    hand_eval_state_init(&hand);
+    for (int i = 0; i < num_cards; i++)
+    {
+        hand_eval_state_add(&hand, cards[i]);
+    }
+    return hand_eval_state_value(&hand);
+}
+
+int hand_eval_set(card_set_t set)
+{
+    int d = card_set_suite(set, DIAMOND);
+    int c = card_set_suite(set, CLUB);
+    int h = card_set_suite(set, HEART);
+    int s = card_set_suite(set, SPADE);
+
+    // flush_value is 0 for any suite with fewer than 5 cards
+    int value = flush_value[d];
+    value = flush_value[c] > value ? flush_value[c] : value;
+    value = flush_value[h] > value ? flush_value[h] : value;
+    value = flush_value[s] > value ? flush_value[s] : value;
+    if (value)
+        return value;
+
+    // count the copies of each rank by adding the four lanes bit by bit
+    int present = d | c | h | s;
+    int at_least_two = (d & c) | (h & s) | ((d | c) & (h | s));
+    int at_least_three = (d & c & (h | s)) | (h & s & (d | c));
+    int quads = d & c & h & s;
+
+    return eval_rank_masks(present, at_least_two & ~at_least_three, at_least_three & ~quads, quads, 0);
+}
+
+/**
+ * fixed size evaluators
+ *
+ * one function per card count and deck, stamped out by a macro so the count is a
+ * constant: the card loop is fully unrolled and there is no check on the size
+ */
+
+#define DEFINE_FIXED_EVAL(name, num_cards, rank_table, flush_table)     \
+    int name(const card_t cards[num_cards])                             \
+    {                                                                   \
+        uint32_t state = 0;                                             \
+        int masks[NUM_SUITES] = { 0 };                                  \
+        _Pragma("GCC unroll 7")                                         \
+        for (int i = 0; i < num_cards; i++)                             \
+        {                                                               \
+            state = rank_next[state][RANK(cards[i])];                   \
+            masks[SUITE(cards[i])] |= 1 << RANK(cards[i]);              \
+        }                                                               \
+        int value = rank_table[state];                                  \
+        value = flush_table[masks[0]] > value ? flush_table[masks[0]] : value; \
+        value = flush_table[masks[1]] > value ? flush_table[masks[1]] : value; \
+        value = flush_table[masks[2]] > value ? flush_table[masks[2]] : value; \
+        value = flush_table[masks[3]] > value ? flush_table[masks[3]] : value; \
+        return value;                                                   \
+    }
+
+DEFINE_FIXED_EVAL(hand_eval_5, 5, rank_value, flush_value)
+DEFINE_FIXED_EVAL(hand_eval_6, 6, rank_value, flush_value)
+DEFINE_FIXED_EVAL(hand_eval_7, 7, rank_value, flush_value)
+DEFINE_FIXED_EVAL(hand_eval_short_5, 5, short_rank_value, short_flush_value)
+DEFINE_FIXED_EVAL(hand_eval_short_6, 6, short_rank_value, short_flush_value)
+DEFINE_FIXED_EVAL(hand_eval_short_7, 7, short_rank_value, short_flush_value)
+
+/**
+ * batch evaluation
+ *
+ * every lane starts from the same incremental hand (empty, or a shared board) and then
+ * adds its own num_lane_cards cards, read with the given stride.
+ */
+
+static void eval_lanes_scalar(const hand_eval_state_t *start, const card_t *cards, int stride, int num_lane_cards,
+                              int num_lanes, int *values)
+{
+    for (int i = 0; i < num_lanes; i++)
+    {
+        const card_t *lane = cards + i * stride;
+        hand_eval_state_t hand = *start;
+        for (int j = 0; j < num_lane_cards; j++)
+        {
+            hand_eval_state_add(&hand, lane[j]);
+        }
+        values[i] = hand_eval_state_value(&hand);
+    }
+}
+
+#ifdef HAND_EVAL_X86
+
+#define AVX2_LANES 8
+
+// 8 hands per iteration, every table read is a gather
+__attribute__((target("avx2")))
+static void eval_8_avx2(const hand_eval_state_t *start, const card_t *cards, int stride, int num_lane_cards, int *values)
+{
+    const __m256i lane_offsets = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(stride));
+    const __m256i suite_bits = _mm256_set1_epi32((1 << SUITE_BITS) - 1);
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i row_len = _mm256_set1_epi32(NUM_RANKS);
+
+    __m256i state = _mm256_set1_epi32(start->state);
+    __m256i masks[NUM_SUITES];
+    for (int s = 0; s < NUM_SUITES; s++)
+    {
+        masks[s] = _mm256_set1_epi32(start->suit_masks[s]);
+    }
+
+    for (int j = 0; j < num_lane_cards; j++)
+    {
+        __m256i card = _mm256_i32gather_epi32(cards + j, lane_offsets, 4);
+        __m256i rank = _mm256_srli_epi32(card, SUITE_BITS);
+        __m256i suite = _mm256_and_si256(card, suite_bits);
+
+        __m256i index = _mm256_add_epi32(_mm256_mullo_epi32(state, row_len), rank);
+        state = _mm256_i32gather_epi32((const int *) rank_next, index, 4);
+
+        __m256i bit = _mm256_sllv_epi32(one, rank);
+        for (int s = 0; s < NUM_SUITES; s++)
+        {
+            __m256i in_suite = _mm256_cmpeq_epi32(suite, _mm256_set1_epi32(s));
+            masks[s] = _mm256_or_si256(masks[s], _mm256_and_si256(in_suite, bit));
+        }
+    }
+
+    __m256i value = _mm256_i32gather_epi32(rank_value, state, 4);
+    for (int s = 0; s < NUM_SUITES; s++)
+    {
+        value = _mm256_max_epi32(value, _mm256_i32gather_epi32(flush_value, masks[s], 4));
+    }
+    _mm256_storeu_si256((__m256i *) values, value);
+}
+
+__attribute__((target("avx2")))
+static void eval_lanes_avx2(const hand_eval_state_t *start, const card_t *cards, int stride, int num_lane_cards,
+                            int num_lanes, int *values)
+{
+    int i = 0;
+    for (; i + AVX2_LANES <= num_lanes; i += AVX2_LANES)
+    {
+        eval_8_avx2(start, cards + i * stride, stride, num_lane_cards, values + i);
+    }
+
+    // pad the leftover lanes with copies of the last hand so they still fill one vector
+    if (i < num_lanes)
+    {
+        card_t padded[AVX2_LANES * MAX_EVAL_CARDS];
+        int padded_values[AVX2_LANES];
+        for (int lane = 0; lane < AVX2_LANES; lane++)
+        {
+            int src = i + lane < num_lanes ? i + lane : num_lanes - 1;
+            memcpy(padded + lane * num_lane_cards, cards + src * stride, num_lane_cards * sizeof(card_t));
+        }
+        eval_8_avx2(start, padded, num_lane_cards, num_lane_cards, padded_values);
+        memcpy(values + i, padded_values, (num_lanes - i) * sizeof(int));
+    }
+}
+
+#endif
+
+static int eval_lanes(const hand_eval_state_t *start, const card_t *cards, int stride, int num_lane_cards,
+                      int num_lanes, int *values)
+{
+    if (num_lanes <= 0)
+        return -1;
+
+#ifdef HAND_EVAL_X86
+    if (use_avx2)
+        eval_lanes_avx2(start, cards, stride, num_lane_cards, num_lanes, values);
+    else
+#endif
+        eval_lanes_scalar(start, cards, stride, num_lane_cards, num_lanes, values);
+
+    int best = 0;
+    for (int i = 1; i < num_lanes; i++)
+    {
+        if (values[i] > values[best])
+            best = i;
+    }
+    return best;
+}
+
+int hand_eval_batch(const card_t *hands, int num_hands, int *values)
+{
+    hand_eval_state_t start;
+    hand_eval_state_init(&start);
+    return eval_lanes(&start, hands, MAX_EVAL_CARDS, MAX_EVAL_CARDS, num_hands, values);
+}
+
+int hand_eval_batch_board(const card_t *hole_cards, int num_hands, const card_t *board, int num_board, int *values)
+{
+    hand_eval_state_t start;
+    hand_eval_state_init(&start);
+    for (int i = 0; i < num_board; i++)
+    {
+        hand_eval_state_add(&start, board[i]);
+    }
+    return eval_lanes(&start, hole_cards, 2, 2, num_hands, values);
+}
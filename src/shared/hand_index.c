@@ -0,0 +1,459 @@
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "hand_index.h"
+#include "card_set.h"
+
+/**
+ * the index of a tuple is built in three layers
+ *
+ * suite: the ranks a suite holds in each round, e.g. {A} in the hole, {2, 9} on the board.
+ *      each round's ranks are numbered as a combination of the ranks that suite has not
+ *      used yet, and the rounds are combined in mixed radix.
+ *
+ * group: suites that got the same number of cards in every round can be renamed into
+ *      each other, so only the multiset of their suite indices matters, numbered as a
+ *      combination with repetition.
+ *
+ * configuration: how many cards each suite got in each round, with the suites sorted.
+ *      every configuration owns a contiguous block of indices, its groups are combined
+ *      in mixed radix inside the block.
+ */
+
+#define NUM_SUITES 4
+#define NUM_RANKS 13
+#define MAX_ROUNDS 2
+#define MAX_CONFIGS 4096
+#define RANK_BITS 0x1fff
+
+typedef struct {
+    uint64_t key;                           // the sorted suite size vectors, see config_key
+    uint16_t vectors[NUM_SUITES];           // cards per round of each suite, in canonical suite order
+    uint64_t offset;                        // first index of this configuration
+    uint64_t count;                         // number of indices it owns
+} index_config_t;
+
+// the rounds are the hole cards and the board, the size of the board depends on the street
+static const int board_sizes[HAND_INDEX_STREETS] = { 0, 3, 4, 5 };
+
+static int street_rounds(int street)
+{
+    return street == HAND_INDEX_PREFLOP ? 1 : 2;
+}
+
+static int round_size(int street, int round)
+{
+    return round == 0 ? 2 : board_sizes[street];
+}
+
+static index_config_t configs[HAND_INDEX_STREETS][MAX_CONFIGS];
+static int num_configs[HAND_INDEX_STREETS];
+static uint64_t street_size[HAND_INDEX_STREETS];
+
+static pthread_once_t tables_once = PTHREAD_ONCE_INIT;
+
+static uint64_t binomial(uint64_t n, int k)
+{
+    if (k < 0 || (uint64_t) k > n)
+        return 0;
+    unsigned __int128 result = 1;
+    for (int i = 1; i <= k; i++)
+    {
+        result = result * (n - k + i) / i;
+    }
+    return (uint64_t) result;
+}
+
+// the size of round j in a suite size vector, round 0 is the most significant nibble
+static int vector_round(uint16_t vector, int round)
+{
+    return (vector >> ((MAX_ROUNDS - 1 - round) * 4)) & 0xf;
+}
+
+// number of different ways a suite can hold the cards of a size vector
+static uint64_t vector_count(uint16_t vector, int num_rounds)
+{
+    uint64_t count = 1;
+    int used = 0;
+    for (int j = 0; j < num_rounds; j++)
+    {
+        count *= binomial(NUM_RANKS - used, vector_round(vector, j));
+        used += vector_round(vector, j);
+    }
+    return count;
+}
+
+static uint64_t config_key(const uint16_t vectors[NUM_SUITES])
+{
+    uint64_t key = 0;
+    for (int s = 0; s < NUM_SUITES; s++)
+    {
+        key = (key << 16) | vectors[s];
+    }
+    return key;
+}
+
+// sorts suites by size vector and then by suite index, both descending
+static void sort_suites(uint16_t vectors[NUM_SUITES], uint64_t indices[NUM_SUITES], int order[NUM_SUITES])
+{
+    for (int i = 1; i < NUM_SUITES; i++)
+    {
+        for (int j = i; j > 0; j--)
+        {
+            int before = vectors[j - 1] > vectors[j] ||
+                         (vectors[j - 1] == vectors[j] && indices[j - 1] >= indices[j]);
+            if (before)
+                break;
+
+            uint16_t v = vectors[j]; vectors[j] = vectors[j - 1]; vectors[j - 1] = v;
+            uint64_t x = indices[j]; indices[j] = indices[j - 1]; indices[j - 1] = x;
+            int o = order[j]; order[j] = order[j - 1]; order[j - 1] = o;
+        }
+    }
+}
+
+static int compare_configs(const void *a, const void *b)
+{
+    const index_config_t *x = a, *y = b;
+    return (x->key > y->key) - (x->key < y->key);
+}
+
+// deals the cards of every round to the suites in every possible way
+static void enumerate_configs(int street, int round, int suite, int left, uint16_t vectors[NUM_SUITES])
+{
+    if (round == street_rounds(street))
+    {
+        uint16_t sorted[NUM_SUITES];
+        uint64_t zeros[NUM_SUITES] = { 0 };
+        int order[NUM_SUITES] = { 0, 1, 2, 3 };
+        memcpy(sorted, vectors, sizeof(sorted));
+        sort_suites(sorted, zeros, order);
+
+        index_config_t *config = &configs[street][num_configs[street]++];
+        memcpy(config->vectors, sorted, sizeof(sorted));
+        config->key = config_key(sorted);
+        return;
+    }
+
+    if (suite == NUM_SUITES - 1)
+    {
+        // the last suite takes whatever is left of the round
+        int shift = (MAX_ROUNDS - 1 - round) * 4;
+        vectors[suite] += left << shift;
+        int next_left = round + 1 < street_rounds(street) ? round_size(street, round + 1) : 0;
+        enumerate_configs(street, round + 1, 0, next_left, vectors);
+        vectors[suite] -= left << shift;
+        return;
+    }
+
+    for (int take = 0; take <= left; take++)
+    {
+        int shift = (MAX_ROUNDS - 1 - round) * 4;
+        vectors[suite] += take << shift;
+        enumerate_configs(street, round, suite + 1, left - take, vectors);
+        vectors[suite] -= take << shift;
+    }
+}
+
+// number of indices a configuration owns: the product of its group multiset counts
+static uint64_t config_count(const uint16_t vectors[NUM_SUITES], int num_rounds)
+{
+    uint64_t count = 1;
+    for (int s = 0; s < NUM_SUITES;)
+    {
+        int k = 1;
+        while (s + k < NUM_SUITES && vectors[s + k] == vectors[s])
+        {
+            k++;
+        }
+        count *= binomial(vector_count(vectors[s], num_rounds) + k - 1, k);
+        s += k;
+    }
+    return count;
+}
+
+static void build_tables()
+{
+    for (int street = 0; street < HAND_INDEX_STREETS; street++)
+    {
+        uint16_t vectors[NUM_SUITES] = { 0 };
+        num_configs[street] = 0;
+        enumerate_configs(street, 0, 0, round_size(street, 0), vectors);
+
+        // sort and drop duplicates, the same configuration comes out once per suite permutation
+        qsort(configs[street], num_configs[street], sizeof(index_config_t), compare_configs);
+        int unique = 0;
+        for (int i = 0; i < num_configs[street]; i++)
+        {
+            if (unique == 0 || configs[street][unique - 1].key != configs[street][i].key)
+                configs[street][unique++] = configs[street][i];
+        }
+        num_configs[street] = unique;
+
+        uint64_t offset = 0;
+        for (int i = 0; i < unique; i++)
+        {
+            configs[street][i].offset = offset;
+            configs[street][i].count = config_count(configs[street][i].vectors, street_rounds(street));
+            offset += configs[street][i].count;
+        }
+        street_size[street] = offset;
+    }
+}
+
+void hand_index_init()
+{
+    pthread_once(&tables_once, build_tables);
+}
+
+int hand_index_street(int num_board)
+{
+    switch (num_board)
+    {
+    case 0:
+        return HAND_INDEX_PREFLOP;
+    case 3:
+        return HAND_INDEX_FLOP;
+    case 4:
+        return HAND_INDEX_TURN;
+    case 5:
+        return HAND_INDEX_RIVER;
+    default:
+        return -1;
+    }
+}
+
+uint64_t hand_index_size(int street)
+{
+    hand_index_init();
+    return street >= 0 && street < HAND_INDEX_STREETS ? street_size[street] : 0;
+}
+
+// colex number of a set of positions
+static uint64_t set_index(int positions)
+{
+    uint64_t index = 0;
+    int i = 1;
+    while (positions)
+    {
+        index += binomial(__builtin_ctz(positions), i++);
+        positions &= positions - 1;
+    }
+    return index;
+}
+
+// the set of size positions with the given colex number
+static int set_unindex(uint64_t index, int size)
+{
+    int positions = 0;
+    for (int i = size; i >= 1; i--)
+    {
+        int c = i - 1;
+        while (binomial(c + 1, i) <= index)
+        {
+            c++;
+        }
+        index -= binomial(c, i);
+        positions |= 1 << c;
+    }
+    return positions;
+}
+
+// numbers a suite's ranks by how many unused ranks sit below them
+static int compact(int ranks, int used)
+{
+    int positions = 0;
+    while (ranks)
+    {
+        int r = __builtin_ctz(ranks);
+        positions |= 1 << (r - __builtin_popcount(used & ((1 << r) - 1)));
+        ranks &= ranks - 1;
+    }
+    return positions;
+}
+
+static int expand(int positions, int used)
+{
+    int ranks = 0;
+    int r = 0, p = 0;
+    while (positions)
+    {
+        if (!(used & (1 << r)))
+        {
+            if (positions & (1 << p))
+            {
+                ranks |= 1 << r;
+                positions &= ~(1 << p);
+            }
+            p++;
+        }
+        r++;
+    }
+    return ranks;
+}
+
+static uint64_t suite_index(const int round_ranks[MAX_ROUNDS], int num_rounds)
+{
+    uint64_t index = 0, mult = 1;
+    int used = 0;
+    for (int j = 0; j < num_rounds; j++)
+    {
+        int size = __builtin_popcount(round_ranks[j]);
+        index += mult * set_index(compact(round_ranks[j], used));
+        mult *= binomial(NUM_RANKS - __builtin_popcount(used), size);
+        used |= round_ranks[j];
+    }
+    return index;
+}
+
+static void suite_unindex(uint64_t index, uint16_t vector, int num_rounds, int round_ranks[MAX_ROUNDS])
+{
+    int used = 0;
+    for (int j = 0; j < num_rounds; j++)
+    {
+        int size = vector_round(vector, j);
+        uint64_t count = binomial(NUM_RANKS - __builtin_popcount(used), size);
+        round_ranks[j] = expand(set_unindex(index % count, size), used);
+        index /= count;
+        used |= round_ranks[j];
+    }
+}
+
+uint64_t hand_index(const card_t hole[2], const card_t *board, int num_board)
+{
+    int street = hand_index_street(num_board);
+    if (street < 0)
+        return UINT64_MAX;
+
+    // the cards of each round as a card set
+    card_set_t rounds[MAX_ROUNDS] = { 0 };
+    card_set_t all = CARD_SET_EMPTY;
+    for (int i = 0; i < 2 + num_board; i++)
+    {
+        card_t card = i < 2 ? hole[i] : board[i - 2];
+        if (card < 0 || card >= DECK_SIZE || card_set_contains(all, card))
+            return UINT64_MAX;
+        all = card_set_add(all, card);
+        rounds[i < 2 ? 0 : 1] |= card_set_of(card);
+    }
+
+    uint16_t vectors[NUM_SUITES];
+    uint64_t indices[NUM_SUITES];
+    int order[NUM_SUITES];
+    for (int s = 0; s < NUM_SUITES; s++)
+    {
+        int round_ranks[MAX_ROUNDS] = { 0 };
+        vectors[s] = 0;
+        for (int j = 0; j < street_rounds(street); j++)
+        {
+            round_ranks[j] = card_set_suite(rounds[j], s);
+            vectors[s] |= __builtin_popcount(round_ranks[j]) << ((MAX_ROUNDS - 1 - j) * 4);
+        }
+        indices[s] = suite_index(round_ranks, street_rounds(street));
+        order[s] = s;
+    }
+    sort_suites(vectors, indices, order);
+
+    index_config_t key = { .key = config_key(vectors) };
+    const index_config_t *config = bsearch(&key, configs[street], num_configs[street], sizeof(index_config_t), compare_configs);
+
+    uint64_t index = 0, mult = 1;
+    for (int s = 0; s < NUM_SUITES;)
+    {
+        int k = 1;
+        while (s + k < NUM_SUITES && vectors[s + k] == vectors[s])
+        {
+            k++;
+        }
+
+        // the group's indices are sorted descending, spread them out into a set and number it
+        uint64_t group = 0;
+        for (int i = 0; i < k; i++)
+        {
+            group += binomial(indices[s + i] + (k - 1 - i), k - i);
+        }
+        index += mult * group;
+        mult *= binomial(vector_count(vectors[s], street_rounds(street)) + k - 1, k);
+        s += k;
+    }
+
+    return config->offset + index;
+}
+
+int hand_unindex(int street, uint64_t index, card_t hole[2], card_t *board)
+{
+    if (street < 0 || street >= HAND_INDEX_STREETS || index >= street_size[street])
+        return -1;
+
+    // the last configuration that starts at or before index
+    int lo = 0, hi = num_configs[street] - 1;
+    while (lo < hi)
+    {
+        int mid = (lo + hi + 1) / 2;
+        if (configs[street][mid].offset <= index)
+            lo = mid;
+        else
+            hi = mid - 1;
+    }
+    const index_config_t *config = &configs[street][lo];
+    index -= config->offset;
+
+    card_set_t rounds[MAX_ROUNDS] = { 0 };
+    for (int s = 0; s < NUM_SUITES;)
+    {
+        int k = 1;
+        while (s + k < NUM_SUITES && config->vectors[s + k] == config->vectors[s])
+        {
+            k++;
+        }
+
+        uint64_t n = vector_count(config->vectors[s], street_rounds(street));
+        uint64_t count = binomial(n + k - 1, k);
+        uint64_t group = index % count;
+        index /= count;
+
+        // undo the spreading: pull out the largest element of the set first
+        for (int i = 0; i < k; i++)
+        {
+            int size = k - i;
+            uint64_t lo_value = size - 1, hi_value = n + k - 2 - i;
+            while (lo_value < hi_value)
+            {
+                uint64_t mid = (lo_value + hi_value + 1) / 2;
+                if (binomial(mid, size) <= group)
+                    lo_value = mid;
+                else
+                    hi_value = mid - 1;
+            }
+            group -= binomial(lo_value, size);
+
+            int round_ranks[MAX_ROUNDS] = { 0 };
+            suite_unindex(lo_value - (k - 1 - i), config->vectors[s], street_rounds(street), round_ranks);
+            for (int j = 0; j < street_rounds(street); j++)
+            {
+                rounds[j] |= (card_set_t) round_ranks[j] << ((s + i) * CARD_SET_LANE_BITS);
+            }
+        }
+        s += k;
+    }
+
+    card_t cards[7];
+    int n = 0;
+    for (int j = 0; j < street_rounds(street); j++)
+    {
+        n += card_set_to_cards(rounds[j], cards + n);
+    }
+    hole[0] = cards[0];
+    hole[1] = cards[1];
+    memcpy(board, cards + 2, (n - 2) * sizeof(card_t));
+    return 0;
+}
+
+int hand_canonicalize(const card_t hole[2], const card_t *board, int num_board, card_t hole_out[2], card_t *board_out)
+{
+    uint64_t index = hand_index(hole, board, num_board);
+    if (index == UINT64_MAX)
+        return -1;
+    return hand_unindex(hand_index_street(num_board), index, hole_out, board_out);
+}
@@ -0,0 +1,410 @@
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "hand_strength.h"
+#include "hand_eval.h"
+#include "hand_index.h"
+#include "card_set.h"
+#include "rng.h"
+#include "platform.h"
+#include "parallel.h"
+
+#define DEADLINE_CHECK_MASK 15   // look at the clock every 16 runouts, each one values every opponent
+#define MAX_OPPONENTS (DECK_SIZE * (DECK_SIZE - 1) / 2)
+
+enum { AHEAD, TIED, BEHIND, NUM_RELATIONS };
+
+// everything the workers need to know about a spot, computed once
+typedef struct {
+    card_t hole[2];
+    int has_board;                          // whether there is a strength now, i.e. not preflop
+    hand_eval_state_t known_board;
+    card_t remaining[DECK_SIZE];            // cards that can still come on the board
+    int num_remaining;
+    int num_missing;                        // community cards still to be dealt
+    int num_opponents;
+    card_t opponents[MAX_OPPONENTS][2];     // every holding that does not clash with the known cards
+    card_set_t opponent_masks[MAX_OPPONENTS];
+    unsigned char now[MAX_OPPONENTS];       // how the hand compares to each holding on the known board
+    double hs;
+} hs_spot_t;
+
+typedef struct {
+    long runouts;
+    long transitions[NUM_RELATIONS][NUM_RELATIONS]; // (relation now, relation on the river) over runouts and holdings
+    double river_hs;
+    double river_hs_sq;
+    long histogram[HS_BUCKETS];
+} hs_tally_t;
+
+typedef struct {
+    const hs_spot_t *spot;
+    int sampling;                           // deal random runouts instead of enumerating
+    long first;                             // enumeration: rank of the first runout
+    long count;                             // enumeration: how many runouts
+    long samples;                           // sampling: how many runouts, 0 for no limit
+    const struct timespec *deadline;        // sampling: NULL for no limit
+    uint64_t seed;
+    hs_tally_t tally;
+} __attribute__((aligned(CACHE_LINE))) hs_worker_t;
+
+typedef struct {
+    uint64_t index;                         // UINT64_MAX for an empty slot
+    long runouts;                           // the runouts the result was computed with
+    hand_strength_t result;
+} hs_cache_entry_t;
+
+struct hand_strength_cache {
+    pthread_mutex_t locks[HAND_INDEX_STREETS];
+    hs_cache_entry_t *entries[HAND_INDEX_STREETS];
+    size_t size;
+    _Atomic uint64_t hits;
+    _Atomic uint64_t misses;
+};
+
+static int relation(int hero, int villain)
+{
+    return hero > villain ? AHEAD : hero == villain ? TIED : BEHIND;
+}
+
+static int prepare_spot(const card_t hole[2], const card_t *board, int num_board, hs_spot_t *spot)
+{
+    if (hand_index_street(num_board) < 0)
+        return -1;
+
+    card_set_t known = CARD_SET_EMPTY;
+    for (int i = 0; i < 2 + num_board; i++)
+    {
+        card_t card = i < 2 ? hole[i] : board[i - 2];
+        if (card < 0 || card >= DECK_SIZE || card_set_contains(known, card))
+            return -1;
+        known = card_set_add(known, card);
+    }
+
+    hand_eval_init();
+    spot->hole[0] = hole[0];
+    spot->hole[1] = hole[1];
+    spot->has_board = num_board > 0;
+    spot->num_missing = 5 - num_board;
+
+    hand_eval_state_init(&spot->known_board);
+    for (int i = 0; i < num_board; i++)
+    {
+        hand_eval_state_add(&spot->known_board, board[i]);
+    }
+
+    spot->num_remaining = card_set_to_cards(card_set_minus(CARD_SET_DECK, known), spot->remaining);
+
+    hand_eval_state_t hero = spot->known_board;
+    hand_eval_state_add(&hero, hole[0]);
+    hand_eval_state_add(&hero, hole[1]);
+    int hero_value = hand_eval_state_value(&hero);
+
+    long ahead = 0, tied = 0;
+    spot->num_opponents = 0;
+    for (int i = 0; i < spot->num_remaining; i++)
+    {
+        for (int j = i + 1; j < spot->num_remaining; j++)
+        {
+            int o = spot->num_opponents++;
+            spot->opponents[o][0] = spot->remaining[i];
+            spot->opponents[o][1] = spot->remaining[j];
+            spot->opponent_masks[o] = card_set_of(spot->remaining[i]) | card_set_of(spot->remaining[j]);
+
+            // preflop every holding counts as tied now, the river decides
+            spot->now[o] = TIED;
+            if (spot->has_board)
+            {
+                hand_eval_state_t villain = spot->known_board;
+                hand_eval_state_add(&villain, spot->remaining[i]);
+                hand_eval_state_add(&villain, spot->remaining[j]);
+                spot->now[o] = relation(hero_value, hand_eval_state_value(&villain));
+            }
+            ahead += spot->now[o] == AHEAD;
+            tied += spot->now[o] == TIED;
+        }
+    }
+    spot->hs = (ahead + tied / 2.0) / spot->num_opponents;
+    return 0;
+}
+
+// compares the hand to every holding the runout leaves possible
+static void tally_runout(const hs_spot_t *spot, const hand_eval_state_t *board, card_set_t runout, hs_tally_t *tally)
+{
+    hand_eval_state_t hero = *board;
+    hand_eval_state_add(&hero, spot->hole[0]);
+    hand_eval_state_add(&hero, spot->hole[1]);
+    int hero_value = hand_eval_state_value(&hero);
+
+    long ahead = 0, tied = 0, seen = 0;
+    for (int o = 0; o < spot->num_opponents; o++)
+    {
+        if (spot->opponent_masks[o] & runout)
+            continue;
+
+        hand_eval_state_t villain = *board;
+        hand_eval_state_add(&villain, spot->opponents[o][0]);
+        hand_eval_state_add(&villain, spot->opponents[o][1]);
+        int river = relation(hero_value, hand_eval_state_value(&villain));
+
+        tally->transitions[spot->now[o]][river]++;
+        ahead += river == AHEAD;
+        tied += river == TIED;
+        seen++;
+    }
+
+    double hs = (ahead + tied / 2.0) / seen;
+    int bucket = (int) (hs * HS_BUCKETS);
+    tally->runouts++;
+    tally->river_hs += hs;
+    tally->river_hs_sq += hs * hs;
+    tally->histogram[bucket < HS_BUCKETS ? bucket : HS_BUCKETS - 1]++;
+}
+
+static void merge_tally(hs_tally_t *into, const hs_tally_t *from)
+{
+    into->runouts += from->runouts;
+    into->river_hs += from->river_hs;
+    into->river_hs_sq += from->river_hs_sq;
+    for (int a = 0; a < NUM_RELATIONS; a++)
+    {
+        for (int b = 0; b < NUM_RELATIONS; b++)
+        {
+            into->transitions[a][b] += from->transitions[a][b];
+        }
+    }
+    for (int b = 0; b < HS_BUCKETS; b++)
+    {
+        into->histogram[b] += from->histogram[b];
+    }
+}
+
+static double ratio(double num, double den)
+{
+    return den > 0 ? num / den : 0;
+}
+
+static void finish_result(const hs_spot_t *spot, const hs_tally_t *tally, hand_strength_t *out)
+{
+    memset(out, 0, sizeof(hand_strength_t));
+    out->runouts = tally->runouts;
+    if (tally->runouts == 0)
+        return;
+
+    out->ehs2 = tally->river_hs_sq / tally->runouts;
+    for (int b = 0; b < HS_BUCKETS; b++)
+    {
+        out->histogram[b] = (double) tally->histogram[b] / tally->runouts;
+    }
+
+    if (!spot->has_board)
+    {
+        out->hs = tally->river_hs / tally->runouts;
+        out->ehs = out->hs;
+        return;
+    }
+
+    const long (*t)[NUM_RELATIONS] = tally->transitions;
+    double behind = t[BEHIND][AHEAD] + t[BEHIND][TIED] + t[BEHIND][BEHIND];
+    double tied = t[TIED][AHEAD] + t[TIED][TIED] + t[TIED][BEHIND];
+    double ahead = t[AHEAD][AHEAD] + t[AHEAD][TIED] + t[AHEAD][BEHIND];
+
+    // ties count half on both sides
+    out->hs = spot->hs;
+    out->ppot = ratio(t[BEHIND][AHEAD] + t[BEHIND][TIED] / 2.0 + t[TIED][AHEAD] / 2.0, behind + tied / 2.0);
+    out->npot = ratio(t[AHEAD][BEHIND] + t[TIED][BEHIND] / 2.0 + t[AHEAD][TIED] / 2.0, ahead + tied / 2.0);
+    out->ehs = out->hs * (1 - out->npot) + (1 - out->hs) * out->ppot;
+}
+
+static void *worker_main(void *arg)
+{
+    hs_worker_t *worker = arg;
+    const hs_spot_t *spot = worker->spot;
+
+    if (!worker->sampling)
+    {
+        int combo[5];
+        unrank_combination(worker->first, spot->num_remaining, spot->num_missing, combo);
+        for (long done = 0; done < worker->count; done++)
+        {
+            hand_eval_state_t board = spot->known_board;
+            card_set_t runout = CARD_SET_EMPTY;
+            for (int k = 0; k < spot->num_missing; k++)
+            {
+                hand_eval_state_add(&board, spot->remaining[combo[k]]);
+                runout = card_set_add(runout, spot->remaining[combo[k]]);
+            }
+            tally_runout(spot, &board, runout, &worker->tally);
+            next_combination(spot->num_remaining, spot->num_missing, combo);
+        }
+        return NULL;
+    }
+
+    rng_t rng;
+    rng_seed(&rng, worker->seed);
+    card_t deck[DECK_SIZE];
+    memcpy(deck, spot->remaining, spot->num_remaining * sizeof(card_t));
+
+    for (long done = 0; worker->samples == 0 || done < worker->samples; done++)
+    {
+        if (worker->deadline && (done & DEADLINE_CHECK_MASK) == 0 && past_deadline(worker->deadline))
+            break;
+
+        // partial Fisher-Yates: only draw the cards the board is missing
+        hand_eval_state_t board = spot->known_board;
+        card_set_t runout = CARD_SET_EMPTY;
+        for (int k = 0; k < spot->num_missing; k++)
+        {
+            int j = k + rng_below(&rng, spot->num_remaining - k);
+            card_t temp = deck[k];
+            deck[k] = deck[j];
+            deck[j] = temp;
+            hand_eval_state_add(&board, deck[k]);
+            runout = card_set_add(runout, deck[k]);
+        }
+        tally_runout(spot, &board, runout, &worker->tally);
+    }
+    return NULL;
+}
+
+int hand_strength(const card_t hole[2], const card_t *board, int num_board, const hand_strength_config_t *config,
+                  hand_strength_t *out)
+{
+    if (!hole || (!board && num_board > 0) || !out)
+        return -1;
+
+    hs_spot_t *spot = malloc(sizeof(hs_spot_t));
+    if (!spot)
+        return -1;
+    if (prepare_spot(hole, board, num_board, spot) == -1)
+    {
+        free(spot);
+        return -1;
+    }
+
+    // sample when there is a time budget or fewer runouts were asked for than there are
+    long total = choose(spot->num_remaining, spot->num_missing);
+    int sampling = config && spot->num_missing > 0 &&
+                   (config->time_budget_ms > 0 || (config->runouts > 0 && config->runouts < total));
+    long samples = sampling ? config->runouts : 0;
+
+    int num_threads = thread_count(config ? config->num_threads : 0, sampling ? samples : total);
+
+    struct timespec deadline;
+    int has_deadline = sampling && config->time_budget_ms > 0;
+    if (has_deadline)
+    {
+        deadline_after(&deadline, config->time_budget_ms);
+    }
+
+    hs_worker_t workers[num_threads];
+    memset(workers, 0, sizeof(workers));
+
+    for (int t = 0; t < num_threads; t++)
+    {
+        workers[t].spot = spot;
+        workers[t].sampling = sampling;
+        split_work(total, num_threads, t, &workers[t].first, &workers[t].count);
+        workers[t].samples = samples > 0 ? samples / num_threads + (t < samples % num_threads) : 0;
+        workers[t].deadline = has_deadline ? &deadline : NULL;
+        workers[t].seed = (config ? config->seed : 0) ^ ((uint64_t) t * 0x9e3779b97f4a7c15ULL);
+    }
+
+    run_workers(worker_main, workers, sizeof(hs_worker_t), num_threads);
+
+    hs_tally_t total_tally;
+    memset(&total_tally, 0, sizeof(total_tally));
+    for (int t = 0; t < num_threads; t++)
+    {
+        merge_tally(&total_tally, &workers[t].tally);
+    }
+
+    finish_result(spot, &total_tally, out);
+    free(spot);
+    return 0;
+}
+
+hand_strength_cache_t *hand_strength_cache_create(size_t entries_per_street)
+{
+    hand_strength_cache_t *cache = calloc(1, sizeof(hand_strength_cache_t));
+    if (!cache)
+        return NULL;
+
+    cache->size = entries_per_street > 0 ? entries_per_street : 1;
+    for (int s = 0; s < HAND_INDEX_STREETS; s++)
+    {
+        pthread_mutex_init(&cache->locks[s], NULL);
+    }
+    for (int s = 0; s < HAND_INDEX_STREETS; s++)
+    {
+        cache->entries[s] = malloc(cache->size * sizeof(hs_cache_entry_t));
+        if (!cache->entries[s])
+        {
+            hand_strength_cache_destroy(cache);
+            return NULL;
+        }
+        for (size_t i = 0; i < cache->size; i++)
+        {
+            cache->entries[s][i].index = UINT64_MAX;
+        }
+    }
+    hand_index_init();
+    return cache;
+}
+
+void hand_strength_cache_destroy(hand_strength_cache_t *cache)
+{
+    if (!cache)
+        return;
+    for (int s = 0; s < HAND_INDEX_STREETS; s++)
+    {
+        pthread_mutex_destroy(&cache->locks[s]);
+        free(cache->entries[s]);
+    }
+    free(cache);
+}
+
+int hand_strength_cached(hand_strength_cache_t *cache, const card_t hole[2], const card_t *board, int num_board,
+                         const hand_strength_config_t *config, hand_strength_t *out)
+{
+    if (!cache || !hole || (!board && num_board > 0) || !out)
+        return -1;
+
+    int street = hand_index_street(num_board);
+    uint64_t index = hand_index(hole, board, num_board);
+    if (street < 0 || index == UINT64_MAX)
+        return -1;
+
+    // time budgeted results are kept apart from the ones with a fixed number of runouts
+    long runouts = !config ? 0 : config->time_budget_ms > 0 ? -1 : config->runouts;
+    hs_cache_entry_t *entry = &cache->entries[street][index % cache->size];
+
+    pthread_mutex_lock(&cache->locks[street]);
+    int hit = entry->index == index && entry->runouts == runouts;
+    if (hit)
+        *out = entry->result;
+    pthread_mutex_unlock(&cache->locks[street]);
+
+    atomic_fetch_add(hit ? &cache->hits : &cache->misses, 1);
+
+    if (hit)
+        return 0;
+    if (hand_strength(hole, board, num_board, config, out) == -1)
+        return -1;
+
+    pthread_mutex_lock(&cache->locks[street]);
+    entry->index = index;
+    entry->runouts = runouts;
+    entry->result = *out;
+    pthread_mutex_unlock(&cache->locks[street]);
+    return 0;
+}
+
+void hand_strength_cache_counts(hand_strength_cache_t *cache, uint64_t *hits, uint64_t *misses)
+{
+    *hits = atomic_load(&cache->hits);
+    *misses = atomic_load(&cache->misses);
+}
@@ -0,0 +1,109 @@
+#include <unistd.h>
+#include <pthread.h>
+
+#include "parallel.h"
+
+int default_threads()
+{
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return cores > 0 ? (int) cores : 1;
+}
+
+int thread_count(int requested, long work)
+{
+    int cores = default_threads();
+    int limit = cores < MAX_THREADS / THREADS_PER_CORE ? cores * THREADS_PER_CORE : MAX_THREADS;
+    int threads = requested > 0 ? requested : cores;
+    if (threads > limit)
+        threads = limit;
+    if (work > 0 && work < threads)
+        threads = (int) work;
+    return threads;
+}
+
+void deadline_after(struct timespec *deadline, double budget_ms)
+{
+    clock_gettime(CLOCK_MONOTONIC, deadline);
+    long long ns = deadline->tv_nsec + (long long) (budget_ms * 1e6);
+    deadline->tv_sec += ns / 1000000000LL;
+    deadline->tv_nsec = ns % 1000000000LL;
+}
+
+int past_deadline(const struct timespec *deadline)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec > deadline->tv_sec ||
+           (now.tv_sec == deadline->tv_sec && now.tv_nsec >= deadline->tv_nsec);
+}
+
+long choose(int n, int k)
+{
+    if (k < 0 || k > n)
+        return 0;
+    long result = 1;
+    for (int i = 1; i <= k; i++)
+    {
+        result = result * (n - k + i) / i;
+    }
+    return result;
+}
+
+void unrank_combination(long rank, int n, int k, int *combo)
+{
+    int next = 0;
+    for (int i = 0; i < k; i++)
+    {
+        // skip every combination that starts with a smaller card
+        while (choose(n - next - 1, k - i - 1) <= rank)
+        {
+            rank -= choose(n - next - 1, k - i - 1);
+            next++;
+        }
+        combo[i] = next++;
+    }
+}
+
+void next_combination(int n, int k, int *combo)
+{
+    int i = k - 1;
+    while (i >= 0 && combo[i] == n - k + i)
+    {
+        i--;
+    }
+    if (i < 0)
+        return;
+    combo[i]++;
+    for (int j = i + 1; j < k; j++)
+    {
+        combo[j] = combo[j - 1] + 1;
+    }
+}
+
+void split_work(long total, int parts, int part, long *first, long *count)
+{
+    long extra = total % parts;
+    *first = total / parts * part + (part < extra ? part : extra);
+    *count = total / parts + (part < extra);
+}
+
+void run_workers(void *(*work)(void *), void *workers, size_t size, int num_workers)
+{
+    char *base = workers;
+    pthread_t threads[num_workers];
+    int started[num_workers];
+
+    for (int t = 0; t < num_workers - 1; t++)
+    {
+        started[t] = pthread_create(&threads[t], NULL, work, base + t * size) == 0;
+        if (!started[t])
+            work(base + t * size);          // could not get another thread, run that share inline
+    }
+    work(base + (num_workers - 1) * size);
+
+    for (int t = 0; t < num_workers - 1; t++)
+    {
+        if (started[t])
+            pthread_join(threads[t], NULL);
+    }
+}
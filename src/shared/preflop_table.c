@@ -0,0 +1,66 @@
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "preflop_table.h"
+
+int preflop_class(card_t a, card_t b)
+{
+    int high = RANK(a) > RANK(b) ? RANK(a) : RANK(b);
+    int low = RANK(a) > RANK(b) ? RANK(b) : RANK(a);
+
+    if (high == low || SUITE(a) == SUITE(b))
+        return high * 13 + low;
+    return low * 13 + high;
+}
+
+int preflop_table_open(preflop_table_t *table, const char *path)
+{
+    memset(table, 0, sizeof(preflop_table_t));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return -1;
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t) st.st_size < sizeof(preflop_table_header_t))
+    {
+        close(fd);
+        return -1;
+    }
+
+    void *data = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd); // the mapping keeps the file alive
+    if (data == MAP_FAILED)
+        return -1;
+
+    const preflop_table_header_t *header = data;
+    size_t heads_up_size = sizeof(float) * PREFLOP_CLASSES * PREFLOP_CLASSES;
+    size_t multiway_size = sizeof(float) * (MAX_PLAYERS - 1) * PREFLOP_CLASSES;
+
+    if (memcmp(header->magic, PREFLOP_TABLE_MAGIC, sizeof(PREFLOP_TABLE_MAGIC)) != 0 ||
+        header->version != PREFLOP_TABLE_VERSION ||
+        header->num_classes != PREFLOP_CLASSES ||
+        header->max_players != MAX_PLAYERS ||
+        header->heads_up_offset + heads_up_size > (uint64_t) st.st_size ||
+        header->multiway_offset + multiway_size > (uint64_t) st.st_size)
+    {
+        munmap(data, st.st_size);
+        return -1;
+    }
+
+    table->data = data;
+    table->size = st.st_size;
+    table->heads_up = (const float *) ((const char *) data + header->heads_up_offset);
+    table->multiway = (const float *) ((const char *) data + header->multiway_offset);
+    return 0;
+}
+
+void preflop_table_close(preflop_table_t *table)
+{
+    if (table->data)
+        munmap((void *) table->data, table->size);
+    memset(table, 0, sizeof(preflop_table_t));
+}
@@ -0,0 +1,70 @@
+#include <string.h>
+
+#include "range.h"
+
+void range_combo_cards(int index, card_t *lo, card_t *hi)
+{
+    int h = 1;
+    while ((h + 1) * h / 2 <= index)
+    {
+        h++;
+    }
+    *hi = h;
+    *lo = index - h * (h - 1) / 2;
+}
+
+card_set_t range_combo_mask(int index)
+{
+    card_t lo, hi;
+    range_combo_cards(index, &lo, &hi);
+    return card_set_of(lo) | card_set_of(hi);
+}
+
+void range_clear(range_t *range)
+{
+    memset(range, 0, sizeof(range_t));
+}
+
+void range_set_hand(range_t *range, card_t a, card_t b, float weight)
+{
+    if (a == b)
+        return;
+    range->weight[range_combo_index(a, b)] = weight;
+}
+
+void range_set_class(range_t *range, int preflop_class, float weight)
+{
+    int row = preflop_class / 13, col = preflop_class % 13;
+
+    for (int s1 = 0; s1 < 4; s1++)
+    {
+        for (int s2 = 0; s2 < 4; s2++)
+        {
+            // pairs and offsuit hands use two different suits, suited hands the same one
+            if ((row > col) != (s1 == s2))
+                continue;
+            if (row == col && s1 >= s2)
+                continue;
+            range_set_hand(range, (row << SUITE_BITS) | s1, (col << SUITE_BITS) | s2, weight);
+        }
+    }
+}
+
+void range_remove_blocked(range_t *range, card_set_t cards)
+{
+    for (int i = 0; i < RANGE_COMBOS; i++)
+    {
+        if (range->weight[i] != 0 && (range_combo_mask(i) & cards))
+            range->weight[i] = 0;
+    }
+}
+
+double range_total_weight(const range_t *range)
+{
+    double total = 0;
+    for (int i = 0; i < RANGE_COMBOS; i++)
+    {
+        total += range->weight[i];
+    }
+    return total;
+}